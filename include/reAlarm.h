@@ -20,8 +20,350 @@
 #include "sys/queue.h"
 #include "esp_timer.h"
 #include "rTypes.h"
+#include "reAlarmEol.h"
+#include "reAlarmPack.h"
 #include "def_alarm.h"
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------- Настройки по умолчанию -------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// Ограничение частоты входящих пакетов по источникам (пакетов в секунду и размер "корзины"), 0 - без ограничений
+#ifndef CONFIG_ALARM_RATE_LIMIT_GPIO
+#define CONFIG_ALARM_RATE_LIMIT_GPIO 0
+#endif
+#ifndef CONFIG_ALARM_RATE_BURST_GPIO
+#define CONFIG_ALARM_RATE_BURST_GPIO 0
+#endif
+#ifndef CONFIG_ALARM_RATE_LIMIT_RX433
+#define CONFIG_ALARM_RATE_LIMIT_RX433 10
+#endif
+#ifndef CONFIG_ALARM_RATE_BURST_RX433
+#define CONFIG_ALARM_RATE_BURST_RX433 20
+#endif
+#ifndef CONFIG_ALARM_RATE_LIMIT_MQTT
+#define CONFIG_ALARM_RATE_LIMIT_MQTT 0
+#endif
+#ifndef CONFIG_ALARM_RATE_BURST_MQTT
+#define CONFIG_ALARM_RATE_BURST_MQTT 0
+#endif
+
+// Журналирование входящих пакетов: ALOG_NONE, ALOG_UNMATCHED, ALOG_SAMPLED (каждый N-й и нераспознанные), ALOG_ALL
+#define ALOG_NONE      0
+#define ALOG_UNMATCHED 1
+#define ALOG_SAMPLED   2
+#define ALOG_ALL       3
+#ifndef CONFIG_ALARM_LOG_FRAMES
+#define CONFIG_ALARM_LOG_FRAMES ALOG_UNMATCHED
+#endif
+#ifndef CONFIG_ALARM_LOG_FRAMES_SAMPLE
+#define CONFIG_ALARM_LOG_FRAMES_SAMPLE 16
+#endif
+#ifndef CONFIG_ALARM_PARAMS_LOG_FRAMES_KEY
+#define CONFIG_ALARM_PARAMS_LOG_FRAMES_KEY "log_frames"
+#endif
+#ifndef CONFIG_ALARM_PARAMS_LOG_FRAMES_FRIENDLY
+#define CONFIG_ALARM_PARAMS_LOG_FRAMES_FRIENDLY "Журнал входящих пакетов"
+#endif
+
+// Кольцевой буфер последних входящих пакетов (0 - отключен) и команда для вывода его в журнал
+#ifndef CONFIG_ALARM_TRACE_SIZE
+#define CONFIG_ALARM_TRACE_SIZE 32
+#endif
+#ifndef CONFIG_ALARM_COMMAND_TRACE_DUMP
+#define CONFIG_ALARM_COMMAND_TRACE_DUMP "alarm_trace"
+#endif
+
+// Сбор статистики работы задачи ОПС и интервал ее публикации на MQTT в секундах (0 - не публиковать)
+#ifndef CONFIG_ALARM_STATS_ENABLE
+#define CONFIG_ALARM_STATS_ENABLE 1
+#endif
+#ifndef CONFIG_ALARM_STATS_INTERVAL
+#define CONFIG_ALARM_STATS_INTERVAL 300
+#endif
+#ifndef CONFIG_ALARM_MQTT_STATS_TOPIC
+#define CONFIG_ALARM_MQTT_STATS_TOPIC "stats"
+#endif
+#ifndef CONFIG_ALARM_MQTT_STATS_LOCAL
+#define CONFIG_ALARM_MQTT_STATS_LOCAL 0
+#endif
+#ifndef CONFIG_ALARM_MQTT_STATS_QOS
+#define CONFIG_ALARM_MQTT_STATS_QOS 0
+#endif
+#ifndef CONFIG_ALARM_MQTT_STATS_RETAINED
+#define CONFIG_ALARM_MQTT_STATS_RETAINED 0
+#endif
+
+// Количество последних отформатированных меток времени, которые хранятся в кэше
+#ifndef CONFIG_ALARM_TIMESTAMP_CACHE_SIZE
+#define CONFIG_ALARM_TIMESTAMP_CACHE_SIZE 4
+#endif
+
+// Двоичная публикация состояния и событий на MQTT (см. reAlarmPack.h): 0 - отключена, 1 - вместе с JSON, 2 - только двоичная
+#ifndef CONFIG_ALARM_MQTT_BINARY
+#define CONFIG_ALARM_MQTT_BINARY 0
+#endif
+#ifndef CONFIG_ALARM_MQTT_BINARY_TOPIC
+#define CONFIG_ALARM_MQTT_BINARY_TOPIC "bin"
+#endif
+
+// Статистика событий датчиков: частоты срабатываний, гистограмма по часам суток, повторы RF-пакетов и признаки аномалий.
+// Аномалия: частота за сутки не менее DAY_LIMIT (0 - не проверять); не менее BURST_MIN срабатываний за час и в BURST_FACTOR раз 
+// больше среднего за час по суточной частоте (только после суток накопления статистики); среднее количество повторов RF-пакета 
+// ниже REPEAT_LOW (после REPEAT_SAMPLES пакетов)
+#ifndef CONFIG_ALARM_EVENT_STATS_ENABLE
+#define CONFIG_ALARM_EVENT_STATS_ENABLE 1
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_INTERVAL
+#define CONFIG_ALARM_EVENT_STATS_INTERVAL 3600
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_DAY_LIMIT
+#define CONFIG_ALARM_EVENT_STATS_DAY_LIMIT 0
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_BURST_MIN
+#define CONFIG_ALARM_EVENT_STATS_BURST_MIN 10
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_BURST_FACTOR
+#define CONFIG_ALARM_EVENT_STATS_BURST_FACTOR 4
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_REPEAT_LOW
+#define CONFIG_ALARM_EVENT_STATS_REPEAT_LOW 3
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_REPEAT_SAMPLES
+#define CONFIG_ALARM_EVENT_STATS_REPEAT_SAMPLES 8
+#endif
+#ifndef CONFIG_ALARM_EVENT_STATS_BUF_SIZE
+#define CONFIG_ALARM_EVENT_STATS_BUF_SIZE 1024
+#endif
+#ifndef CONFIG_ALARM_MQTT_EVENT_STATS_TOPIC
+#define CONFIG_ALARM_MQTT_EVENT_STATS_TOPIC "sensors"
+#endif
+
+// Измерение задержек обработки сигналов по этапам
+#ifndef CONFIG_ALARM_LATENCY_ENABLE
+#define CONFIG_ALARM_LATENCY_ENABLE 1
+#endif
+
+// Правила подтверждения тревог: максимальное количество правил (не более 32) и размер окна событий для правил ARL_K_OF_N
+#ifndef CONFIG_ALARM_MAX_RULES
+#define CONFIG_ALARM_MAX_RULES 8
+#endif
+#ifndef CONFIG_ALARM_RULE_WINDOW_SIZE
+#define CONFIG_ALARM_RULE_WINDOW_SIZE 8
+#endif
+
+// Разделы (группы зон с независимым режимом охраны): наименование основного раздела и шаблоны уведомлений для остальных разделов
+#ifndef CONFIG_ALARM_PARTITION_MAIN_NAME
+#define CONFIG_ALARM_PARTITION_MAIN_NAME "Основной"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_MAX_LEN
+#define CONFIG_ALARM_COMMAND_MAX_LEN 32
+#endif
+#ifndef CONFIG_NOTIFY_TELEGRAM_ALARM_PARTITION_MODE
+#define CONFIG_NOTIFY_TELEGRAM_ALARM_PARTITION_MODE "Раздел <b>%s</b>: %s\nИсточник: %s"
+#endif
+#ifndef CONFIG_NOTIFY_TELEGRAM_ALARM_PARTITION_ACTIVATED
+#define CONFIG_NOTIFY_TELEGRAM_ALARM_PARTITION_ACTIVATED "Раздел <b>%s</b>: задержка на выход истекла, режим охраны активирован"
+#endif
+
+// Исключение зон из охраны: команды и группа параметров (флаги исключения зон сохраняются в параметрах)
+#ifndef CONFIG_ALARM_COMMAND_BYPASS
+#define CONFIG_ALARM_COMMAND_BYPASS "alarm_bypass"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_INHIBIT
+#define CONFIG_ALARM_COMMAND_INHIBIT "alarm_inhibit"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_RESTORE
+#define CONFIG_ALARM_COMMAND_RESTORE "alarm_restore"
+#endif
+
+// Команды: запрос состояния, длительность сирены, ответы на команды и размеры хэш-таблиц команд и индексов зон и датчиков (степени двойки)
+#ifndef CONFIG_ALARM_COMMAND_STATUS
+#define CONFIG_ALARM_COMMAND_STATUS "alarm_status"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_SIREN
+#define CONFIG_ALARM_COMMAND_SIREN "alarm_siren"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_HASH_SIZE
+#define CONFIG_ALARM_COMMAND_HASH_SIZE 64
+#endif
+#ifndef CONFIG_ALARM_TOPIC_INDEX_SIZE
+#define CONFIG_ALARM_TOPIC_INDEX_SIZE 32
+#endif
+#ifndef CONFIG_ALARM_COMMAND_REPLY_SIZE
+#define CONFIG_ALARM_COMMAND_REPLY_SIZE 192
+#endif
+#ifndef CONFIG_ALARM_COMMAND_REPLY_OK
+#define CONFIG_ALARM_COMMAND_REPLY_OK "%s: выполнено"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_REPLY_NOT_FOUND
+#define CONFIG_ALARM_COMMAND_REPLY_NOT_FOUND "%s: [ %s ] не найден"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_REPLY_PARTITION
+#define CONFIG_ALARM_COMMAND_REPLY_PARTITION "Раздел %s: %s, тревог: %d"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_REPLY_ZONE
+#define CONFIG_ALARM_COMMAND_REPLY_ZONE "Зона %s: активных событий: %d, исключение: %d, раздел: %s"
+#endif
+#ifndef CONFIG_ALARM_COMMAND_REPLY_SIREN
+#define CONFIG_ALARM_COMMAND_REPLY_SIREN "Длительность сирены: %d с"
+#endif
+#ifndef CONFIG_ALARM_MQTT_REPLY_TOPIC
+#define CONFIG_ALARM_MQTT_REPLY_TOPIC "reply"
+#endif
+#ifndef CONFIG_ALARM_MQTT_REPLY_LOCAL
+#define CONFIG_ALARM_MQTT_REPLY_LOCAL 0
+#endif
+#ifndef CONFIG_ALARM_MQTT_REPLY_QOS
+#define CONFIG_ALARM_MQTT_REPLY_QOS 1
+#endif
+#ifndef CONFIG_ALARM_PARAMS_BYPASS_KEY
+#define CONFIG_ALARM_PARAMS_BYPASS_KEY "bypass"
+#endif
+#ifndef CONFIG_ALARM_PARAMS_BYPASS_FRIENDLY
+#define CONFIG_ALARM_PARAMS_BYPASS_FRIENDLY "Исключение зон"
+#endif
+#ifndef CONFIG_ALARM_PARAMS_BYPASS_UNTIL_KEY
+#define CONFIG_ALARM_PARAMS_BYPASS_UNTIL_KEY "bypass_until"
+#endif
+#ifndef CONFIG_ALARM_PARAMS_BYPASS_UNTIL_FRIENDLY
+#define CONFIG_ALARM_PARAMS_BYPASS_UNTIL_FRIENDLY "Срок исключения зон"
+#endif
+
+// Контроль связи с датчиками: шаг и количество ячеек колеса таймеров, субтопик события "датчик потерян"
+#ifndef CONFIG_ALARM_SUPERVISION_TICK
+#define CONFIG_ALARM_SUPERVISION_TICK 10
+#endif
+#ifndef CONFIG_ALARM_SUPERVISION_SLOTS
+#define CONFIG_ALARM_SUPERVISION_SLOTS 64
+#endif
+#ifndef CONFIG_ALARM_MQTT_EVENTS_ASE_LOST
+#define CONFIG_ALARM_MQTT_EVENTS_ASE_LOST "lost"
+#endif
+
+// Аналоговые проводные зоны с оконечными резисторами: количество входов, период опроса АЦП в мс, число отсчетов для усреднения
+#ifndef CONFIG_ALARM_EOL_MAX_INPUTS
+#define CONFIG_ALARM_EOL_MAX_INPUTS 8
+#endif
+#ifndef CONFIG_ALARM_EOL_PERIOD
+#define CONFIG_ALARM_EOL_PERIOD 20
+#endif
+#ifndef CONFIG_ALARM_EOL_OVERSAMPLE
+#define CONFIG_ALARM_EOL_OVERSAMPLE 4
+#endif
+#ifndef CONFIG_ALARM_EOL_STACK_SIZE
+#define CONFIG_ALARM_EOL_STACK_SIZE 2048
+#endif
+
+// Декодеры входных сигналов: максимальное количество типов датчиков (встроенных и зарегистрированных, не более 32) и размер хэш-индекса датчиков
+#ifndef CONFIG_ALARM_MAX_SENSOR_TYPES
+#define CONFIG_ALARM_MAX_SENSOR_TYPES 16
+#endif
+#ifndef CONFIG_ALARM_SENSOR_INDEX_SIZE
+#define CONFIG_ALARM_SENSOR_INDEX_SIZE 64
+#endif
+
+// Пульты с плавающим кодом: окно допустимого опережения счетчика, интервал в мс, в течение которого повтор того же кода
+// считается продолжением нажатия, субтопик события "повтор кода" и группа параметров для сохранения счетчиков
+#ifndef CONFIG_ALARM_ROLLING_WINDOW
+#define CONFIG_ALARM_ROLLING_WINDOW 16
+#endif
+#ifndef CONFIG_ALARM_ROLLING_REPEAT
+#define CONFIG_ALARM_ROLLING_REPEAT 1500
+#endif
+// Счетчик сохраняется во flash не чаще, чем через заданное количество кодов (и при синхронизации). Должно быть меньше окна,
+// чтобы после перезапуска следующий код пульта попал в окно
+#ifndef CONFIG_ALARM_ROLLING_STORE_INTERVAL
+#define CONFIG_ALARM_ROLLING_STORE_INTERVAL 8
+#endif
+#ifndef CONFIG_ALARM_MQTT_EVENTS_ASE_REPLAY
+#define CONFIG_ALARM_MQTT_EVENTS_ASE_REPLAY "replay"
+#endif
+#ifndef CONFIG_ALARM_PARAMS_ROLLING_KEY
+#define CONFIG_ALARM_PARAMS_ROLLING_KEY "rolling"
+#endif
+#ifndef CONFIG_ALARM_PARAMS_ROLLING_FRIENDLY
+#define CONFIG_ALARM_PARAMS_ROLLING_FRIENDLY "Счетчики пультов"
+#endif
+
+// Подавление дребезга проводных входов: максимальное количество входов с фильтром
+#ifndef CONFIG_ALARM_DEBOUNCE_MAX_INPUTS
+#define CONFIG_ALARM_DEBOUNCE_MAX_INPUTS 16
+#endif
+
+// Детектор подавления (глушения) радиоканала: окно в миллисекундах, количество нераспознанных пакетов для установки и сброса
+#ifndef CONFIG_ALARM_JAMMING_WINDOW
+#define CONFIG_ALARM_JAMMING_WINDOW 10000
+#endif
+#ifndef CONFIG_ALARM_JAMMING_THRESHOLD_SET
+#define CONFIG_ALARM_JAMMING_THRESHOLD_SET 50
+#endif
+#ifndef CONFIG_ALARM_JAMMING_THRESHOLD_CLR
+#define CONFIG_ALARM_JAMMING_THRESHOLD_CLR 10
+#endif
+#ifndef CONFIG_ALARM_JAMMING_NAME
+#define CONFIG_ALARM_JAMMING_NAME "RX433"
+#endif
+#ifndef CONFIG_ALARM_JAMMING_TOPIC
+#define CONFIG_ALARM_JAMMING_TOPIC "rx433"
+#endif
+
+// Записи событий RE_ALARM_SIGNAL_SET / RE_ALARM_SIGNAL_CLEAR: размер пула
+#ifndef CONFIG_ALARM_EVENT_POOL_SIZE
+#define CONFIG_ALARM_EVENT_POOL_SIZE 16
+#endif
+// Количество попыток отправить RE_ALARM_RECORD_RELEASE; если все неудачны, запись остается занятой
+#ifndef CONFIG_ALARM_EVENT_RELEASE_ATTEMPTS
+#define CONFIG_ALARM_EVENT_RELEASE_ATTEMPTS 10
+#endif
+
+// Снимок состояния для чтения из других задач: максимальное количество зон в снимке
+#ifndef CONFIG_ALARM_SNAPSHOT_MAX_ZONES
+#define CONFIG_ALARM_SNAPSHOT_MAX_ZONES 16
+#endif
+
+// Локальный HTTP / WebSocket сервис состояния (требуется esp_http_server, для WebSocket - CONFIG_HTTPD_WS_SUPPORT)
+#ifndef CONFIG_ALARM_WEB_ENABLE
+#define CONFIG_ALARM_WEB_ENABLE 0
+#endif
+#ifndef CONFIG_ALARM_WEB_STATUS_URI
+#define CONFIG_ALARM_WEB_STATUS_URI "/security/status"
+#endif
+#ifndef CONFIG_ALARM_WEB_SOCKET_URI
+#define CONFIG_ALARM_WEB_SOCKET_URI "/security/ws"
+#endif
+#ifndef CONFIG_ALARM_WEB_BUFFER_SIZE
+#define CONFIG_ALARM_WEB_BUFFER_SIZE 2048
+#endif
+#ifndef CONFIG_ALARM_WEB_MAX_CLIENTS
+#define CONFIG_ALARM_WEB_MAX_CLIENTS 8
+#endif
+// Минимальный интервал между рассылками клиентам WebSocket, мс
+#ifndef CONFIG_ALARM_WEB_PUSH_INTERVAL
+#define CONFIG_ALARM_WEB_PUSH_INTERVAL 200
+#endif
+
+// Классы входной очереди: глубина очереди внешних значений (MQTT), при переполнении вытесняются самые старые значения. 
+// Глубина очереди проводных входов - CONFIG_ALARM_QUEUE_SIZE, при переполнении источник ожидает освобождения места
+#ifndef CONFIG_ALARM_QUEUE_BULK_SIZE
+#define CONFIG_ALARM_QUEUE_BULK_SIZE 16
+#endif
+
+// Задача реакций: публикация на MQTT и уведомления Telegram выполняются отдельной задачей с более низким приоритетом на другом ядре. 
+// Размер кольцевого буфера действий (0 - все выполняется в основной задаче), размер стека, приоритет и ядро задачи
+#ifndef CONFIG_ALARM_EFFECTS_QUEUE_SIZE
+#define CONFIG_ALARM_EFFECTS_QUEUE_SIZE 32
+#endif
+#ifndef CONFIG_ALARM_EFFECTS_STACK_SIZE
+#define CONFIG_ALARM_EFFECTS_STACK_SIZE 4096
+#endif
+#ifndef CONFIG_ALARM_EFFECTS_PRIORITY
+#define CONFIG_ALARM_EFFECTS_PRIORITY (CONFIG_TASK_PRIORITY_ALARM - 1)
+#endif
+#ifndef CONFIG_ALARM_EFFECTS_CORE
+#define CONFIG_ALARM_EFFECTS_CORE 0
+#endif
+
 // -----------------------------------------------------------------------------------------------------------------------
 // -------------------------------------------------- Типы данных --------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
@@ -55,6 +397,34 @@ static const uint16_t ASRS_ALARM_SIREN  = ASR_ALARM_INC | ASR_MQTT_EVENT | ASR_M
 static const uint16_t ASRS_POWER_ON     = ASR_MQTT_EVENT | ASR_MQTT_STATUS | ASR_TELEGRAM | ASR_FLASHER;
 static const uint16_t ASRS_POWER_OFF    = ASR_ALARM_INC | ASR_MQTT_EVENT | ASR_MQTT_STATUS | ASR_TELEGRAM | ASR_BUZZER | ASR_FLASHER;
 
+/**
+ * ИСКЛЮЧЕНИЕ ИЗ ОХРАНЫ
+ * 
+ * Исключенные зоны и события датчиков не вызывают реакций. Сброс сигнала, установленного до исключения, обрабатывается
+ * */
+static const uint8_t AZB_NONE    = 0x00;   // Зона (событие) под охраной
+static const uint8_t AZB_BYPASS  = BIT0;   // Исключена до снятия раздела с охраны
+static const uint8_t AZB_INHIBIT = BIT1;   // Исключена до восстановления вручную
+static const uint8_t AZB_IGNORED = BIT7;   // Служебный флаг события: событие или его зона исключены
+
+/**
+ * ДЕЙСТВИЯ ПЛАНА РЕАКЦИИ
+ * 
+ * Битовые маски реакций компилируются в упорядоченный список действий: сначала исполнительные устройства, затем сеть
+ * */
+typedef enum {
+  ASA_END = 0,            // Конец списка
+  ASA_SIREN,              // Включить сирену
+  ASA_FLASHER,            // Включить маячок
+  ASA_BUZZER,             // Звуковой сигнал на пульте
+  ASA_RELAY_ON,           // Включить реле
+  ASA_RELAY_OFF,          // Выключить реле
+  ASA_RELAY_SWITCH,       // Переключить реле
+  ASA_MQTT_EVENT,         // Публикация события на MQTT
+  ASA_TELEGRAM,           // Уведомление в Telegram
+  ASA_MAX
+} alarm_action_t;
+
 /**
  * ТИП ДАТЧИКА
  * 
@@ -64,9 +434,15 @@ typedef enum {
   AST_WIRED = 0,          // Проводная зона
   AST_RX433_GENERIC,      // Беспроводной сенсор, без выделения команд
   AST_RX433_20A4C,        // Беспроводной сенсор, общая длина кода 24 бит: 20 бит - адрес, последние 4 бита - команда
-  AST_MQTT                // Виртуальный сенсор, получение данных с других устройств через локальный MQTT брокер
+  AST_MQTT,               // Виртуальный сенсор, получение данных с других устройств через локальный MQTT брокер
+  AST_WIRED_EOL,          // Проводная зона с оконечными резисторами: address - канал ADC1, value_set событий - маска состояний AEL_MASK_xxx
+  AST_RX433_ROLLING,      // Беспроводной пульт с плавающим кодом: address - серийный номер, value_set событий - команда
+  AST_CUSTOM = 8          // Первый номер для типов, декодеры которых регистрируются через alarmDecoderRegister()
 } alarm_sensor_type_t;
 
+// Номер "шины" в gpio_data_t, которым помечаются изменения состояния аналоговых зон (pin - канал АЦП, value - alarm_eol_state_t)
+static const uint8_t ALARM_EOL_BUS = 0xEE;
+
 /**
  * ИСТОЧНИК СИГНАЛА УПРАВЛЕНИЯ
  * 
@@ -93,8 +469,34 @@ typedef enum {
   ASM_MAX                // Не используется
 } alarm_mode_t;
 
+// Вызывается при изменении режима любого раздела; режим основного раздела - alarmPartitionModeGet(nullptr)
 typedef void (*cb_alarm_change_mode_t) (alarm_mode_t mode, alarm_control_t source);
 
+/**
+ * ПОЛИТИКА СИРЕНЫ РАЗДЕЛА
+ * 
+ * Определяет, какие оповещатели включаются по реакции ASR_SIREN в зонах раздела
+ * */
+typedef enum {
+  ASP_SIREN = 0,          // Сирена и маячок в соответствии с реакциями зоны
+  ASP_FLASHER,            // Сирена заменяется маячком
+  ASP_SILENT              // Сирена и маячок не включаются, только уведомления
+} alarm_siren_policy_t;
+
+/**
+ * СОСТОЯНИЕ ЗАДЕРЖКИ ЗОНЫ
+ * 
+ * Задержки на вход и выход отсчитываются для каждой зоны отдельно
+ * */
+typedef enum {
+  AZS_IDLE = 0,           // Задержка не действует
+  AZS_EXIT,               // Задержка на выход: события зоны не учитываются
+  AZS_ENTRY               // Задержка на вход: реакция на тревогу отложена до истечения задержки или снятия с охраны
+} alarm_zone_delay_t;
+
+// Использовать общее время задержки на выход (параметр "exit_time")
+static const uint16_t ALARM_DELAY_DEFAULT = 0xFFFF;
+
 /**
  * ТИП СОБЫТИЯ
  * 
@@ -109,13 +511,27 @@ typedef enum {
   ASE_CTRL_OFF,           // Пульт: режим охраны отключен
   ASE_CTRL_ON,            // Пульт: режим охраны включен
   ASE_CTRL_PERIMETER,     // Пульт: режим охраны периметра
-  ASE_CTRL_OUTBUILDINGS   // Пульт: режим охраны внешних помещений
+  ASE_CTRL_OUTBUILDINGS,  // Пульт: режим охраны внешних помещений
+  ASE_LOST,               // Потеря связи с датчиком: нет сигналов дольше интервала контроля
+  ASE_REPLAY              // Пульт с плавающим кодом: повтор перехваченного кода или счетчик вне окна
 } alarm_event_t;
 
+/**
+ * ПРАВИЛА ПОДТВЕРЖДЕНИЯ
+ * 
+ * Правила корреляции событий с разных датчиков, заменяющие общий таймер подтверждения
+ * */
+typedef enum {
+  ARL_K_OF_N = 0,         // Не менее K разных датчиков зоны в течение окна
+  ARL_SEQUENCE,           // Событие A, затем событие B в течение окна
+  ARL_UNLESS              // Событие X не вызывает тревогу, если в течение окна было событие Y
+} alarm_rule_type_t;
+
 /**
  * СИСТЕМНЫЕ СОБЫТИЯ 
  * 
- * Отправка уведомлений в системный цикл событий
+ * Отправка уведомлений в системный цикл событий. 
+ * RE_ALARM_SIGNAL_SET и RE_ALARM_SIGNAL_CLEAR передают указатель на неизменяемую запись alarmEventRecord_t
  * */
 static const char* RE_ALARM_EVENTS = "REVT_ALARM";
 
@@ -133,13 +549,35 @@ typedef enum {
   RE_ALARM_FLASHER_BLINK,
   RE_ALARM_RELAY_ON,
   RE_ALARM_RELAY_OFF,
-  RE_ALARM_RELAY_TOGGLE
+  RE_ALARM_RELAY_TOGGLE,
+  RE_ALARM_JAMMING_ON,
+  RE_ALARM_JAMMING_OFF,
+  RE_ALARM_ENTRY_DELAY,
+  RE_ALARM_PARTITION_MODE,
+  RE_ALARM_REPLAY,
+  RE_ALARM_RECORD_RELEASE,  // Служебное: освобождение записи события после обработки всеми подписчиками
+  RE_ALARM_ANOMALY          // Аномалия статистики события, данные - alarmAnomaly_t
 } re_alarm_event_id_t;
 
 // -----------------------------------------------------------------------------------------------------------------------
 // --------------------------------------------------- Структуры ---------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
+struct alarmSensor_t;
+struct alarmEvent_t;
+
+// Раздел: группа зон с собственным режимом охраны, счетчиком тревог, задержкой на выход и политикой сирены
+typedef struct alarmPartition_t *alarmPartitionHandle_t;
+
+// Состояние зоны, скопированное задачей ОПС для публикации статуса другой задачей
+typedef struct {
+  uint16_t status;
+  uint8_t  bypass;
+  bool     relay;
+  time_t   last_set;
+  time_t   last_clr;
+} alarmZoneValues_t;
+
 // Параметры зоны
 typedef struct alarmZone_t {
   const char* name;
@@ -151,6 +589,27 @@ typedef struct alarmZone_t {
   bool relay_state = false;
   uint16_t resp_set[ASM_MAX];
   uint16_t resp_clr[ASM_MAX];
+  uint8_t  plan_set[ASM_MAX][ASA_MAX];
+  uint8_t  plan_clr[ASM_MAX][ASA_MAX];
+  uint32_t rules;
+  uint16_t exit_delay;
+  uint16_t entry_delay;
+  alarm_zone_delay_t delay_state;
+  int64_t  delay_end;
+  struct alarmSensor_t* entry_sensor;
+  struct alarmEvent_t* entry_event;
+  bool entry_confirmed;
+  alarmPartitionHandle_t partition;
+  uint8_t  bypass;
+  time_t   bypass_until;
+  void*    param_bypass;          // paramsEntryHandle_t
+  uint32_t bypass_expires;        // Копия bypass_until для хранения в параметрах, 0 - без ограничения
+  void*    param_bypass_until;    // paramsEntryHandle_t
+  alarmZoneValues_t values;       // Состояние на момент последней постановки статуса в очередь публикации
+  uint32_t topic_id;              // Идентификатор топика (хэш), вычисляется при добавлении зоны
+  uint32_t name_id;               // Идентификатор наименования (хэш)
+  struct alarmZone_t* topic_next;
+  struct alarmZone_t* name_next;
   STAILQ_ENTRY(alarmZone_t) next;
 } alarmZone_t;
 // Ссылка-указатель на параметры зоны
@@ -158,6 +617,29 @@ typedef alarmZone_t *alarmZoneHandle_t;
 
 static const uint32_t ALARM_VALUE_NONE = 0xFFFFFFFF;
 
+/**
+ * АНОМАЛИИ СТАТИСТИКИ СОБЫТИЯ
+ * */
+typedef enum {
+  AAN_NONE = 0,           // Нет
+  AAN_RATE,               // Слишком частые срабатывания за сутки
+  AAN_BURST,              // Всплеск срабатываний за последний час
+  AAN_WEAK_SIGNAL         // Мало повторов RF-пакета: слабый сигнал
+} alarm_anomaly_t;
+
+// Статистика события (фиксированный объем памяти, обновляется за O(1) на каждый сигнал)
+typedef struct {
+  float    rate_hour;             // Экспоненциально затухающий счетчик срабатываний с постоянной времени 1 час
+  float    rate_day;              // То же с постоянной времени 1 сутки
+  uint32_t rate_time;             // Время обновления счетчиков (секунды с момента запуска)
+  uint32_t rate_since;            // Время первого срабатывания, с которого накапливается суточная частота
+  uint16_t hourly[24];            // Количество срабатываний по часам суток
+  uint8_t  repeat_min;            // Минимальное количество повторов RF-пакета с момента последней публикации, 0 - нет данных
+  uint16_t repeat_avg;            // Скользящее среднее количества повторов RF-пакета * 16
+  uint32_t repeat_count;          // Количество учтенных RF-пакетов
+  uint8_t  anomaly;               // Текущая аномалия (alarm_anomaly_t)
+} alarmEventStats_t;
+
 // Параметры события (сигнала с датчика)
 typedef struct alarmEvent_t {
   alarmZoneHandle_t zone;
@@ -176,6 +658,13 @@ typedef struct alarmEvent_t {
   time_t   mqtt_next;
   esp_timer_handle_t timer_clr = nullptr;
   void* timer_data = nullptr;
+  uint32_t rules;
+  bool     suppressed;
+  uint8_t  bypass;
+  time_t   bypass_until;
+  #if CONFIG_ALARM_EVENT_STATS_ENABLE
+  alarmEventStats_t stats;
+  #endif // CONFIG_ALARM_EVENT_STATS_ENABLE
 } alarmEvent_t;
 // Ссылка-указатель на параметры события
 typedef alarmEvent_t *alarmEventHandle_t;
@@ -188,17 +677,187 @@ typedef struct alarmSensor_t {
   bool local_publish;
   uint32_t address;
   alarmEvent_t events[CONFIG_ALARM_MAX_EVENTS];
+  uint32_t supervision;           // Интервал контроля связи в секундах, 0 - не контролируется
+  uint32_t seen;                  // Время последнего сигнала (секунды с момента запуска)
+  uint32_t wheel_rounds;
+  bool wheel_active;
+  bool lost;
+  uint32_t rolling;               // Плавающий код: биты 0-15 - последний принятый счетчик, ALARM_ROLLING_SYNCED - счетчик синхронизирован
+  uint16_t rolling_resync;        // Счетчик вне окна, ожидающий подтверждения следующим кодом
+  uint16_t rolling_stored;        // Последний сохраненный в параметрах счетчик
+  bool rolling_pending;
+  uint32_t rolling_time;          // Время приема последнего кода в мс
+  void* param_rolling;
+  LIST_ENTRY(alarmSensor_t) wheel;
+  struct alarmSensor_t* index_next;
+  uint32_t topic_id;              // Идентификатор топика (хэш), вычисляется при добавлении датчика
+  uint32_t name_id;               // Идентификатор наименования (хэш)
+  struct alarmSensor_t* topic_next;
+  struct alarmSensor_t* name_next;
   STAILQ_ENTRY(alarmSensor_t) next;
 } alarmSensor_t;
 // Ссылка-указатель на параметры датчика
 typedef alarmSensor_t *alarmSensorHandle_t;
 
+// Данные события RE_ALARM_ANOMALY
+typedef struct {
+  alarm_sensor_type_t sensor_type;
+  uint32_t sensor_address;        // Идентификатор датчика: тип и адрес
+  uint8_t event_index;            // Индекс события датчика
+  alarm_event_t event_type;
+  alarm_anomaly_t anomaly;
+} alarmAnomaly_t;
+
+/**
+ * Декодер типа датчика: извлечение ключа
+ * @brief Возвращает ключ входного сигнала, который сравнивается с address датчика
+ * @param data Входной сигнал
+ * @param key Извлеченный ключ (адрес датчика)
+ * @return false, если сигнал не относится к данному типу датчиков
+ * */
+typedef bool (*cb_alarm_decoder_key_t) (input_data_t* data, uint32_t* key);
+
+/**
+ * Декодер типа датчика: извлечение команды
+ * @brief Возвращает команду входного сигнала, которая сравнивается с value_set и value_clr событий датчика
+ * @param data Входной сигнал
+ * @param command Извлеченная команда
+ * @return false, если команду выделить не удалось
+ * */
+typedef bool (*cb_alarm_decoder_command_t) (input_data_t* data, uint32_t* command);
+
+// Признак синхронизации счетчика плавающего кода
+static const uint32_t ALARM_ROLLING_SYNCED = 0x10000;
+
+/**
+ * Декодер плавающего кода
+ * @brief Расшифровывает принятый код пульта AST_RX433_ROLLING
+ * @param code Код, принятый приемником RX433
+ * @param serial Серийный номер пульта (сравнивается с address датчика)
+ * @param counter Счетчик нажатий
+ * @param command Команда (сравнивается с value_set и value_clr событий)
+ * @return true, если код расшифрован
+ * */
+typedef bool (*cb_alarm_rolling_decode_t) (uint32_t code, uint32_t* serial, uint16_t* counter, uint8_t* command);
+
+/**
+ * Ответ на команду
+ * @brief Вызывается для каждой строки ответа в контексте задачи, выполняющей команду
+ * @param reply Текст ответа
+ * @param ctx Контекст канала, из которого поступила команда
+ * */
+typedef void (*cb_alarm_command_reply_t) (const char* reply, void* ctx);
+
 // Данные для обаботки события
 typedef struct {
   alarmSensorHandle_t sensor;
   alarmEventHandle_t event;
+  int64_t timestamp;              // Время поступления входного сигнала (esp_timer_get_time), 0 - неизвестно
 } alarmEventData_t;
 
+/**
+ * КЛАССЫ ВХОДНЫХ СИГНАЛОВ
+ * 
+ * Очереди классов выбираются задачей строго по приоритету
+ * */
+typedef enum {
+  AQC_ALARM = 0,          // Проводные входы (GPIO, EOL): никогда не отбрасываются
+  AQC_CONTROL,            // Сигналы RX433 (пульты и беспроводные датчики): очередь драйвера приемника
+  AQC_BULK,               // Внешние значения (MQTT): при переполнении вытесняются самые старые
+  AQC_MAX
+} alarm_queue_class_t;
+
+// Версия формата записи события
+#define ALARM_EVENT_RECORD_VERSION 1
+
+/**
+ * Запись события датчика
+ * @brief Копия состояния на момент события, не изменяется после публикации. Запись действительна во время вызова обработчика; 
+ *        чтобы использовать ее позже, подписчик вызывает alarmEventRecordRetain() и затем alarmEventRecordRelease()
+ * */
+typedef struct {
+  uint8_t version;                // ALARM_EVENT_RECORD_VERSION
+  uint32_t seq;                   // Порядковый номер записи
+  alarm_sensor_type_t sensor_type;
+  uint32_t sensor_address;        // Идентификатор датчика: тип и адрес
+  const char* sensor_name;
+  const char* sensor_topic;
+  const char* zone_name;
+  const char* zone_topic;
+  uint8_t event_index;            // Индекс события датчика
+  alarm_event_t event_type;
+  bool state;                     // true - тревога установлена, false - сброшена
+  uint32_t events_count;
+  time_t event_last;
+  uint16_t zone_status;
+  alarm_mode_t mode;              // Режим раздела зоны
+  int64_t timestamp;              // Время поступления входного сигнала (esp_timer_get_time), 0 - неизвестно
+  uint32_t refs;
+} alarmEventRecord_t;
+
+// Снимок состояния (alarmSnapshot_t) не зависит от ESP-IDF и описан вместе с его сериализацией
+#include "reAlarmWeb.h"
+
+// Внешнее значение для пакетной отправки в очередь
+typedef struct {
+  source_type_t source;
+  uint32_t id;                    // Идентификатор события (адрес виртуального сенсора)
+  uint32_t value;
+} alarmExtValue_t;
+
+/**
+ * ЭТАПЫ ОБРАБОТКИ СИГНАЛА
+ * 
+ * Задержка каждого этапа отсчитывается от момента поступления входного сигнала
+ * */
+typedef enum {
+  ALS_DEQUEUE = 0,        // Сигнал извлечен из очереди и передан на обработку
+  ALS_MATCH,              // Определены датчик и событие
+  ALS_DECISION,           // Определены реакции на событие
+  ALS_SIREN,              // Команда на включение сирены
+  ALS_FLASHER,            // Команда на включение маячка
+  ALS_BUZZER,             // Команда зуммеру
+  ALS_MQTT,               // Событие опубликовано на MQTT
+  ALS_TELEGRAM,           // Уведомление поставлено в очередь Telegram
+  ALS_MAX
+} alarm_latency_stage_t;
+
+// Гистограмма длительностей: корзина i содержит значения от 2^(i-1) до 2^i микросекунд
+#define ALARM_STATS_BUCKETS 20
+
+typedef struct {
+  uint32_t count;
+  uint32_t max;
+  uint64_t total;
+  uint32_t buckets[ALARM_STATS_BUCKETS];
+} alarmHistogram_t;
+
+// Статистика работы задачи ОПС
+typedef struct {
+  uint32_t frames_gpio;
+  uint32_t frames_rx433;
+  uint32_t frames_mqtt;
+  uint32_t frames_matched;
+  uint32_t frames_unmatched;
+  uint32_t frames_dropped;
+  uint32_t frames_filtered;
+  uint32_t frames_replayed;
+  uint32_t queue_hwm;
+  uint32_t queue_class_hwm[AQC_MAX];
+  uint32_t queue_bulk_dropped;
+  uint32_t effects_overflow;    // Действия, выполненные в основной задаче из-за переполнения буфера задачи реакций
+  uint32_t timers_created;
+  uint32_t timers_failed;
+  alarmHistogram_t responses;   // Время выполнения alarmResponsesProcess
+  alarmHistogram_t mqtt;        // Время публикации на MQTT
+  alarmHistogram_t telegram;    // Время постановки уведомления в очередь Telegram
+  alarmHistogram_t siren;       // Время от получения сигнала из очереди до команды на включение сирены
+} alarmStats_t;
+
+#if CONFIG_ALARM_WEB_ENABLE
+#include "esp_http_server.h"
+#endif // CONFIG_ALARM_WEB_ENABLE
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -261,6 +920,66 @@ QueueHandle_t alarmTaskQueue();
  * */
 alarmZoneHandle_t alarmZoneAdd(const char* name, const char* topic, cb_relay_control_t cb_relay_ctrl);
 
+/**
+ * Найти зону
+ * @brief Поиск по хэш-индексу без учета регистра: сначала по топику, затем по наименованию
+ * @param key Топик или наименование зоны
+ * @return Ссылка-указатель на зону или nullptr
+ * */
+alarmZoneHandle_t alarmZoneFind(const char* key);
+
+/**
+ * Задержки зоны
+ * @brief Установить задержки на выход и вход для зоны
+ * @param zone Ссылка-указатель на зону
+ * @param exit_delay Задержка на выход в секундах после постановки на охрану с кнопок или пульта. ALARM_DELAY_DEFAULT - общая задержка
+ * @param entry_delay Задержка на вход в секундах: тревога ASE_ALARM в зоне вызывает реакцию, только если охрана не снята за это время
+ * */
+void alarmZoneDelaysSet(alarmZoneHandle_t zone, uint16_t exit_delay, uint16_t entry_delay);
+
+/**
+ * Добавить раздел
+ * @brief Добавить раздел ОПС. Зоны, не привязанные к разделу, относятся к основному разделу
+ * @param name Понятное наименование раздела
+ * @param topic Субтопик раздела: используется для параметра режима, статуса на MQTT и в командах ("alarm_on garage")
+ * @param siren_policy Политика включения сирены для зон раздела
+ * @return Ссылка-указатель на созданный раздел
+ * */
+alarmPartitionHandle_t alarmPartitionAdd(const char* name, const char* topic, alarm_siren_policy_t siren_policy);
+
+/**
+ * Найти раздел
+ * @brief Найти раздел по субтопику
+ * @param topic Субтопик раздела
+ * @return Ссылка-указатель на раздел или nullptr
+ * */
+alarmPartitionHandle_t alarmPartitionFind(const char* topic);
+
+/**
+ * Режим охраны раздела
+ * @brief Получить текущий режим охраны раздела
+ * @param partition Ссылка-указатель на раздел. Если nullptr, то основной раздел
+ * @return Режим охраны
+ * */
+alarm_mode_t alarmPartitionModeGet(alarmPartitionHandle_t partition);
+
+/**
+ * Привязать зону к разделу
+ * @brief Перенести зону в раздел. События ASE_CTRL_xxx в зоне управляют режимом этого раздела
+ * @param zone Ссылка-указатель на зону
+ * @param partition Ссылка-указатель на раздел. Если nullptr, то основной раздел
+ * */
+void alarmZonePartitionSet(alarmZoneHandle_t zone, alarmPartitionHandle_t partition);
+
+/**
+ * Исключить зону из охраны
+ * @brief Установить или снять исключение зоны. Флаги зоны сохраняются в параметрах
+ * @param zone Ссылка-указатель на зону
+ * @param bypass AZB_BYPASS, AZB_INHIBIT или AZB_NONE для восстановления
+ * @param duration Срок исключения в секундах, 0 - без ограничения
+ * */
+void alarmZoneBypassSet(alarmZoneHandle_t zone, uint8_t bypass, uint32_t duration);
+
 /**
  * Добавить реакции на события
  * @brief Добавить реакции на события (битовые флаги) для выбранной зоны и режима. 
@@ -284,6 +1003,71 @@ void alarmResponsesSet(alarmZoneHandle_t zone, alarm_mode_t mode, uint16_t resp_
  * */
 alarmSensorHandle_t alarmSensorAdd(alarm_sensor_type_t type, const char* name, const char* topic, bool local_publish, uint32_t address);
 
+/**
+ * Найти датчик
+ * @brief Поиск по хэш-индексу без учета регистра: сначала по топику, затем по наименованию
+ * @param key Топик или наименование датчика
+ * @return Ссылка-указатель на датчик или nullptr
+ * */
+alarmSensorHandle_t alarmSensorFind(const char* key);
+
+/**
+ * Пороги аналоговой зоны
+ * @brief Задать пороги классификации для датчика AST_WIRED_EOL и включить опрос его канала АЦП
+ * @param sensor Ссылка-указатель на датчик
+ * @param thresholds Пороги классификации, гистерезис и количество отсчетов для подтверждения
+ * @return Успех или неуспех
+ * */
+bool alarmSensorEolSet(alarmSensorHandle_t sensor, const alarmEolThresholds_t* thresholds);
+
+/**
+ * Зарегистрировать декодер типа датчиков
+ * @brief Новый протокол добавляется без изменения кода обработки: ключ сигнала сразу используется для поиска датчика в индексе. 
+ *        Декодеры вызываются, только если есть хотя бы один датчик данного типа
+ * @param type Тип датчика: AST_CUSTOM и далее для новых протоколов или встроенный тип для замены его декодера
+ * @param source Источник входных сигналов, для которых вызывается декодер
+ * @param key Функция извлечения ключа (адреса датчика)
+ * @param command Функция извлечения команды. Если nullptr, любой сигнал датчика устанавливает событие (как AST_RX433_GENERIC)
+ * @return Успех или неуспех
+ * */
+bool alarmDecoderRegister(alarm_sensor_type_t type, source_type_t source, cb_alarm_decoder_key_t key, cb_alarm_decoder_command_t command);
+
+/**
+ * Декодер пультов с плавающим кодом
+ * @brief Задать функцию расшифровки кодов для всех датчиков AST_RX433_ROLLING. По умолчанию используется открытый формат: 
+ *        биты 16-31 - счетчик, биты 4-15 - серийный номер, биты 0-3 - команда
+ * @param decoder Функция расшифровки или nullptr для формата по умолчанию
+ * */
+void alarmRollingDecoderSet(cb_alarm_rolling_decode_t decoder);
+
+/**
+ * Сбросить синхронизацию пульта с плавающим кодом
+ * @brief Следующий код пульта будет принят как новая точка отсчета счетчика
+ * @param sensor Ссылка-указатель на датчик AST_RX433_ROLLING
+ * */
+void alarmRollingResync(alarmSensorHandle_t sensor);
+
+/**
+ * Подавление дребезга проводной зоны
+ * @brief Новый уровень на входе датчика AST_WIRED передается на обработку, только если он удерживается заданное время. 
+ *        Переходы, не дождавшиеся подтверждения, отбрасываются до сопоставления с событиями
+ * @param sensor Ссылка-указатель на датчик
+ * @param stable_ms Время в мс, в течение которого уровень должен оставаться неизменным. 0 - фильтр отключен
+ * @param pulse_ms Минимальная длительность активного уровня (value_set первого события) в мс для извещателей со счетом импульсов. 
+ *        0 - используется stable_ms
+ * @return Успех или неуспех
+ * */
+bool alarmSensorDebounceSet(alarmSensorHandle_t sensor, uint16_t stable_ms, uint16_t pulse_ms);
+
+/**
+ * Контроль связи с датчиком
+ * @brief Если от датчика нет ни одного сигнала дольше заданного интервала, вызывается событие датчика с типом ASE_LOST
+ *        (если оно задано). Первый сигнал после потери связи сбрасывает это событие
+ * @param sensor Ссылка-указатель на датчик
+ * @param interval Интервал контроля в секундах, 0 - отключить контроль
+ * */
+void alarmSensorSupervisionSet(alarmSensorHandle_t sensor, uint32_t interval);
+
 /**
  * Добавить событие датчика
  * @brief Установить команду датчика в заданную зону
@@ -304,6 +1088,68 @@ void alarmEventSet(alarmSensorHandle_t sensor, alarmZoneHandle_t zone, uint8_t i
   uint32_t value_set, const char* message_set, uint32_t value_clear, const char* message_clr, 
   uint16_t threshold, uint32_t timeout_clr, uint16_t mqtt_interval, bool alarm_confirm);
 
+/**
+ * Получить событие датчика
+ * @brief Получить ссылку-указатель на событие датчика по его индексу
+ * @param sensor Ссылка-указатель на датчик
+ * @param index Порядковый индекс команды от 0 до CONFIG_ALARM_MAX_EVENTS-1
+ * @return Ссылка-указатель на событие или nullptr
+ * */
+alarmEventHandle_t alarmEventGet(alarmSensorHandle_t sensor, uint8_t index);
+
+/**
+ * Исключить событие датчика из охраны
+ * @brief Установить или снять исключение отдельного события датчика (не сохраняется)
+ * @param event Ссылка-указатель на событие
+ * @param bypass AZB_BYPASS, AZB_INHIBIT или AZB_NONE для восстановления
+ * @param duration Срок исключения в секундах, 0 - без ограничения
+ * */
+void alarmEventBypassSet(alarmEventHandle_t event, uint8_t bypass, uint32_t duration);
+
+/**
+ * Правило "K из N"
+ * @brief Тревога с флагом alarm_confirm в зоне подтверждается, если за window_ms сработали не менее k разных датчиков этой зоны
+ * @param zone Ссылка-указатель на зону
+ * @param k Количество разных датчиков (не более CONFIG_ALARM_RULE_WINDOW_SIZE)
+ * @param window_ms Окно в миллисекундах
+ * @return Номер правила или -1 в случае ошибки
+ * */
+int8_t alarmRuleAddKofN(alarmZoneHandle_t zone, uint8_t k, uint32_t window_ms);
+
+/**
+ * Правило "A затем B"
+ * @brief Тревога по событию second подтверждается, если не ранее чем за window_ms до него произошло событие first
+ * @param first Ссылка-указатель на первое событие
+ * @param second Ссылка-указатель на второе событие
+ * @param window_ms Окно в миллисекундах
+ * @return Номер правила или -1 в случае ошибки
+ * */
+int8_t alarmRuleAddSequence(alarmEventHandle_t first, alarmEventHandle_t second, uint32_t window_ms);
+
+/**
+ * Правило "X, если не Y"
+ * @brief Тревога по событию event подавляется, если за window_ms до него произошло событие inhibitor
+ * @param event Ссылка-указатель на событие
+ * @param inhibitor Ссылка-указатель на подавляющее событие
+ * @param window_ms Окно в миллисекундах
+ * @return Номер правила или -1 в случае ошибки
+ * */
+int8_t alarmRuleAddUnless(alarmEventHandle_t event, alarmEventHandle_t inhibitor, uint32_t window_ms);
+
+/**
+ * Захватить запись события
+ * @brief Продлить время жизни записи, полученной в обработчике RE_ALARM_SIGNAL_SET / RE_ALARM_SIGNAL_CLEAR
+ * @param record Указатель на запись
+ * */
+void alarmEventRecordRetain(const alarmEventRecord_t* record);
+
+/**
+ * Освободить запись события
+ * @brief Вернуть запись, захваченную alarmEventRecordRetain(), в пул
+ * @param record Указатель на запись
+ * */
+void alarmEventRecordRelease(const alarmEventRecord_t* record);
+
 /**
  * Отправить внешнее событие в очередь обработки
  * @brief Отправить внешнее событие в очередь обработки ОПС
@@ -313,6 +1159,116 @@ void alarmEventSet(alarmSensorHandle_t sensor, alarmZoneHandle_t zone, uint8_t i
  * */
 bool alarmPostQueueExtId(source_type_t source, uint32_t id, uint8_t value);
 
+/**
+ * Отправить пакет внешних событий в очередь обработки
+ * @brief Все значения помещаются в очередь внешних значений (AQC_BULK) за одну операцию, задача ОПС пробуждается один раз. 
+ *        Функция никогда не блокирует вызывающую задачу
+ * @param values Массив значений
+ * @param count Количество значений в массиве
+ * @param displace true - при переполнении вытесняются самые старые значения (принимаются все значения), 
+ *        false - значения принимаются, пока в очереди есть место
+ * @param displaced Количество вытесненных из очереди значений (может быть nullptr), они учитываются также в queue_bulk_dropped
+ * @return Количество принятых значений; 0, если хотя бы одно значение имеет источник IDS_GPIO или IDS_RX433
+ * */
+uint16_t alarmPostQueueExtBatch(const alarmExtValue_t* values, uint16_t count, bool displace, uint16_t* displaced);
+
+/**
+ * Отправить пакет внешних событий в очередь обработки с ожиданием
+ * @brief Значения не вытесняют другие: при заполнении очереди вызывающая задача ожидает освобождения места
+ * @param values Массив значений
+ * @param count Количество значений в массиве
+ * @param wait Максимальное время ожидания в тиках (portMAX_DELAY - без ограничения)
+ * @return Количество принятых значений, меньше count только по истечении времени ожидания. 
+ *         0, если хотя бы одно значение имеет источник IDS_GPIO или IDS_RX433
+ * */
+uint16_t alarmPostQueueExtBatchWait(const alarmExtValue_t* values, uint16_t count, TickType_t wait);
+
+/**
+ * Глубина входной очереди
+ * @brief Возвращает количество сигналов, ожидающих обработки в очереди заданного класса
+ * @param qclass Класс входных сигналов
+ * */
+uint32_t alarmQueueDepth(alarm_queue_class_t qclass);
+
+/**
+ * Выполнить команду
+ * @brief Команды RE_SYS_COMMAND выполняются так же, ответ на них публикуется в топике CONFIG_ALARM_MQTT_REPLY_TOPIC.
+ * Аргумент отделяется пробелом: топик раздела для режимов и сброса тревоги, "<зона> [секунды]" или "<датчик>:<событие> [секунды]" 
+ * для исключения, топик раздела или зоны для CONFIG_ALARM_COMMAND_STATUS, секунды для CONFIG_ALARM_COMMAND_SIREN.
+ * Команды изменяют режим охраны и сбрасывают тревоги так же, как изменение параметров через MQTT, поэтому функцию можно 
+ * вызывать только в задаче основного цикла событий (например, из обработчика события). Из других задач отправляйте 
+ * команду событием RE_SYS_COMMAND
+ * @param command Команда с аргументами
+ * @param reply Функция для передачи ответа в канал, из которого поступила команда (может быть nullptr)
+ * @param ctx Контекст канала, передается в reply
+ * @return false, если команда не относится к ОПС
+ * */
+bool alarmCommandExec(const char* command, cb_alarm_command_reply_t reply, void* ctx);
+
+/**
+ * Снимок состояния
+ * @brief Получить согласованную копию состояния ОПС без блокировки задачи ОПС. Можно вызывать из любой задачи с высокой частотой
+ * @param snapshot Указатель на структуру для копирования данных
+ * */
+void alarmSnapshotGet(alarmSnapshot_t* snapshot);
+
+/**
+ * Статистика работы
+ * @brief Получить копию счетчиков и гистограмм задачи ОПС
+ * @param stats Указатель на структуру для копирования данных
+ * */
+void alarmStatsGet(alarmStats_t* stats);
+
+/**
+ * Задержка обработки сигналов
+ * @brief Получить оценку процентиля задержки для заданного этапа обработки (по логарифмической гистограмме)
+ * @param stage Этап обработки
+ * @param percentile Процентиль от 1 до 100
+ * @return Верхняя граница задержки в микросекундах, 0 если нет данных
+ * */
+uint32_t alarmLatencyPercentile(alarm_latency_stage_t stage, uint8_t percentile);
+
+/**
+ * Гистограмма задержек
+ * @brief Получить копию гистограммы задержек для заданного этапа обработки
+ * @param stage Этап обработки
+ * @param hist Указатель на структуру для копирования данных
+ * */
+void alarmLatencyGet(alarm_latency_stage_t stage, alarmHistogram_t* hist);
+
+/**
+ * Сброс статистики
+ * @brief Обнулить счетчики и гистограммы задачи ОПС
+ * */
+void alarmStatsReset();
+
+/**
+ * Настроить детектор подавления радиоканала
+ * @brief Привязать событие "глушение RX433" к зоне. Событие обрабатывается как ASE_TAMPER с реакциями, заданными для зоны
+ * @param zone Ссылка-указатель на зону. Если nullptr, то событие только отправляется в системный цикл событий
+ * @param message_set Сообщение при обнаружении подавления радиоканала
+ * @param message_clr Сообщение при восстановлении радиоканала
+ * */
+void alarmJammingSet(alarmZoneHandle_t zone, const char* message_set, const char* message_clr);
+
+#if CONFIG_ALARM_WEB_ENABLE
+
+/**
+ * Подключить сервис состояния к HTTP-серверу
+ * @brief Регистрирует на сервере GET CONFIG_ALARM_WEB_STATUS_URI (текущее состояние в JSON) и WebSocket CONFIG_ALARM_WEB_SOCKET_URI. 
+ * Новый клиент WebSocket сразу получает полное состояние, затем при каждом изменении - только изменившиеся зоны ("delta":1)
+ * @param server Запущенный HTTP-сервер
+ * */
+bool alarmWebRegister(httpd_handle_t server);
+
+/**
+ * Отключить сервис состояния
+ * @brief Снять регистрацию обработчиков. Необходимо вызвать перед остановкой HTTP-сервера
+ * */
+void alarmWebUnregister();
+
+#endif // CONFIG_ALARM_WEB_ENABLE
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,87 @@
+/* 
+   EN: Classification of the analog signal of a wired zone with end-of-line resistors
+   RU: Классификация аналогового сигнала проводной зоны с оконечными резисторами
+   --------------------------
+   (с) 2021-2022 Разживин Александр | Razzhivin Alexander
+   kotyara12@yandex.ru | https://kotyara12.ru | tg: @kotyara1971
+   --------------------------
+   Не зависит от ESP-IDF и может собираться и проверяться на хосте с записанными последовательностями отсчетов
+*/
+
+#ifndef __RE_ALARM_EOL_H__
+#define __RE_ALARM_EOL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * СОСТОЯНИЕ ШЛЕЙФА
+ * 
+ * Состояния перечислены в порядке возрастания напряжения на входе
+ * */
+typedef enum {
+  AEL_SHORT = 0,          // Короткое замыкание шлейфа
+  AEL_NORMAL,             // Норма: замкнутый контакт и оконечный резистор
+  AEL_ALARM,              // Тревога: контакт разомкнут, в цепи оба резистора
+  AEL_TAMPER,             // Обрыв шлейфа
+  AEL_UNKNOWN             // Состояние еще не определено
+} alarm_eol_state_t;
+
+// Маски состояний для value_set событий датчика AST_WIRED_EOL
+#define AEL_MASK(state) (1UL << (state))
+static const uint32_t AEL_MASK_ALARM  = AEL_MASK(AEL_ALARM);
+static const uint32_t AEL_MASK_TAMPER = AEL_MASK(AEL_TAMPER) | AEL_MASK(AEL_SHORT);
+
+// Пороги классификации (в отсчетах АЦП) для одной зоны
+typedef struct {
+  uint16_t short_max;     // Значение не выше этого порога - короткое замыкание
+  uint16_t normal_max;    // Значение не выше этого порога - норма
+  uint16_t alarm_max;     // Значение не выше этого порога - тревога, выше - обрыв
+  uint16_t hysteresis;    // Гистерезис на каждой границе
+  uint8_t  debounce;      // Количество подряд идущих отсчетов для смены состояния
+} alarmEolThresholds_t;
+
+// Фильтр состояния одной зоны
+typedef struct {
+  alarm_eol_state_t state;
+  alarm_eol_state_t candidate;
+  uint8_t count;
+} alarmEolFilter_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Классификация отсчета
+ * @brief Определить состояние шлейфа по значению с учетом гистерезиса относительно текущего состояния
+ * @param thresholds Пороги зоны
+ * @param current Текущее состояние шлейфа
+ * @param value Значение АЦП
+ * @return Состояние шлейфа
+ * */
+alarm_eol_state_t alarmEolClassify(const alarmEolThresholds_t* thresholds, alarm_eol_state_t current, uint16_t value);
+
+/**
+ * Инициализация фильтра
+ * @brief Сбросить фильтр в состояние AEL_UNKNOWN
+ * @param filter Указатель на фильтр
+ * */
+void alarmEolFilterInit(alarmEolFilter_t* filter);
+
+/**
+ * Обработка отсчета
+ * @brief Классифицировать отсчет и подтвердить смену состояния после debounce одинаковых отсчетов подряд
+ * @param filter Указатель на фильтр
+ * @param thresholds Пороги зоны
+ * @param value Значение АЦП
+ * @return true, если состояние шлейфа изменилось (новое состояние в filter->state)
+ * */
+bool alarmEolFilterUpdate(alarmEolFilter_t* filter, const alarmEolThresholds_t* thresholds, uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RE_ALARM_EOL_H__
@@ -0,0 +1,100 @@
+/* 
+   EN: Compact binary encoding of alarm status and events for MQTT
+   RU: Компактное двоичное представление состояния и событий ОПС для MQTT
+   --------------------------
+   (с) 2021-2022 Разживин Александр | Razzhivin Alexander
+   kotyara12@yandex.ru | https://kotyara12.ru | tg: @kotyara1971
+   --------------------------
+   Все поля записываются в порядке little-endian без выравнивания, время - unix time (секунды, 0 - нет данных). 
+   Библиотека MQTT принимает только строки, поэтому пакет публикуется в кодировке base64
+
+   Событие (APK_EVENT, 12 байт):
+     0  u8   версия схемы (ALARM_PACK_SCHEMA)
+     1  u8   тип пакета
+     2  u8   тип события (alarm_event_t)
+     3  u8   состояние: 1 - тревога, 0 - норма
+     4  u32  количество срабатываний
+     8  u32  время последнего срабатывания
+
+   Состояние раздела (APK_STATUS, 23 + 11 * N байт):
+     0  u8   версия схемы (ALARM_PACK_SCHEMA)
+     1  u8   тип пакета
+     2  u8   режим охраны (alarm_mode_t)
+     3  u8   оповещатели: бит 0 - сирена, бит 1 - маячок
+     4  u16  количество тревог
+     6  u32  время последнего события в зонах раздела
+     10 u32  адрес датчика последнего события
+     14 u32  время последней тревоги в зонах раздела
+     18 u32  адрес датчика последней тревоги
+     22 u8   количество зон N, далее для каждой зоны раздела в порядке добавления:
+        u16  количество активных событий зоны
+        u8   бит 0 - реле, биты 1-2 - исключение из охраны (AZB_BYPASS | AZB_INHIBIT)
+        u32  время последней тревоги
+        u32  время последнего сброса
+*/
+
+#ifndef __RE_ALARM_PACK_H__
+#define __RE_ALARM_PACK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Версия схемы пакетов, увеличивается при любом изменении формата
+#define ALARM_PACK_SCHEMA 1
+
+/**
+ * ТИП ПАКЕТА
+ * */
+typedef enum {
+  APK_EVENT = 1,          // Событие датчика
+  APK_STATUS              // Состояние раздела
+} alarm_pack_kind_t;
+
+// Размеры пакетов
+#define ALARM_PACK_EVENT_SIZE 12
+#define ALARM_PACK_STATUS_HEADER_SIZE 23
+#define ALARM_PACK_STATUS_ZONE_SIZE 11
+
+// Буфер для записи пакета
+typedef struct {
+  uint8_t* buf;
+  size_t size;
+  size_t len;
+  bool overflow;
+} alarmPack_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Начать пакет
+ * @brief Записать в буфер версию схемы и тип пакета
+ * @param pack Буфер пакета
+ * @param buf Память для данных
+ * @param size Размер памяти
+ * @param kind Тип пакета
+ * */
+void alarmPackInit(alarmPack_t* pack, uint8_t* buf, size_t size, alarm_pack_kind_t kind);
+
+/**
+ * Записать значение
+ * @brief При нехватке места значение не записывается и устанавливается признак overflow
+ * */
+void alarmPackU8(alarmPack_t* pack, uint8_t value);
+void alarmPackU16(alarmPack_t* pack, uint16_t value);
+void alarmPackU32(alarmPack_t* pack, uint32_t value);
+
+/**
+ * Закодировать пакет
+ * @brief Возвращает строку base64 в динамической памяти (освобождается вызывающей стороной) или NULL
+ * @param pack Буфер пакета
+ * */
+char* alarmPackBase64(const alarmPack_t* pack);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RE_ALARM_PACK_H__
@@ -0,0 +1,101 @@
+/*
+   EN: Alarm status snapshot and its JSON serialization for the local web service
+   RU: Снимок состояния ОПС и его сериализация в JSON для локального web-сервиса
+   --------------------------
+   (с) 2021-2022 Разживин Александр | Razzhivin Alexander
+   kotyara12@yandex.ru | https://kotyara12.ru | tg: @kotyara1971
+   --------------------------
+   Не зависит от ESP-IDF и может собираться и проверяться на хосте
+
+   Полное состояние ("delta":0) содержит все зоны снимка. Изменение ("delta":1) содержит общие поля и только те зоны,
+   которые изменились с момента последней отправки
+*/
+
+#ifndef __RE_ALARM_WEB_H__
+#define __RE_ALARM_WEB_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+// Максимальное количество зон в снимке
+#ifndef CONFIG_ALARM_SNAPSHOT_MAX_ZONES
+#define CONFIG_ALARM_SNAPSHOT_MAX_ZONES 16
+#endif
+
+// Состояние зоны в снимке
+typedef struct {
+  const char* topic;              // Топик зоны
+  uint8_t mode;                   // Режим охраны раздела, к которому относится зона (alarm_mode_t)
+  uint16_t status;                // Количество активных событий зоны
+  uint8_t bypass;                 // Исключение из охраны (AZB_BYPASS | AZB_INHIBIT)
+  bool relay;                     // Состояние реле зоны
+  time_t last_set;                // Время последней тревоги
+  time_t last_clr;                // Время последнего сброса
+} alarmSnapshotZone_t;
+
+// Согласованный снимок состояния ОПС
+typedef struct {
+  uint32_t seq;                   // Номер снимка, увеличивается при каждом обновлении
+  uint8_t mode;                   // Режим охраны основного раздела (alarm_mode_t)
+  uint16_t alarms;                // Количество тревог основного раздела
+  bool siren;                     // Сирена включена
+  bool flasher;                   // Маячок включен
+  time_t last_alarm;              // Время последней тревоги
+  time_t last_event;              // Время последнего события
+  uint8_t zones_count;            // Количество зон в снимке (не более CONFIG_ALARM_SNAPSHOT_MAX_ZONES)
+  alarmSnapshotZone_t zones[CONFIG_ALARM_SNAPSHOT_MAX_ZONES];
+} alarmSnapshot_t;
+
+// Последнее отправленное клиентам состояние
+typedef struct {
+  alarmSnapshot_t sent;
+  bool valid;
+} alarmWebDelta_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Сравнение зон
+ * @brief Проверить, изменилось ли состояние зоны
+ * @return true, если хотя бы одно поле зоны отличается
+ * */
+bool alarmWebZoneChanged(const alarmSnapshotZone_t* a, const alarmSnapshotZone_t* b);
+
+/**
+ * Сериализация снимка
+ * @brief Записать снимок в буфер в формате JSON
+ * @param snapshot Снимок состояния
+ * @param prev Предыдущий отправленный снимок: если задан, неизменившиеся зоны пропускаются ("delta":1). nullptr - полное состояние
+ * @param buf Буфер
+ * @param size Размер буфера
+ * @return Длина строки без завершающего нуля, 0 - буфер слишком мал
+ * */
+size_t alarmWebFormat(const alarmSnapshot_t* snapshot, const alarmSnapshot_t* prev, char* buf, size_t size);
+
+/**
+ * Сброс отправленного состояния
+ * @brief Следующая рассылка будет содержать полное состояние
+ * @param delta Указатель на отправленное состояние
+ * */
+void alarmWebDeltaReset(alarmWebDelta_t* delta);
+
+/**
+ * Подготовка рассылки
+ * @brief Сериализовать изменения относительно последней рассылки и запомнить снимок как отправленный
+ * @param delta Указатель на отправленное состояние
+ * @param snapshot Новый снимок состояния
+ * @param buf Буфер
+ * @param size Размер буфера
+ * @return Длина строки; 0 - снимок не изменился, рассылать нечего; -1 - буфер слишком мал
+ * */
+int alarmWebDeltaFormat(alarmWebDelta_t* delta, const alarmSnapshot_t* snapshot, char* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RE_ALARM_WEB_H__
@@ -4,12 +4,17 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
 #include <time.h>
+#include <math.h>
 #include "esp_err.h"
 #include "esp_timer.h"
 #include <driver/gpio.h>
+#include <driver/adc.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "rLog.h"
 #include "rStrings.h"
 #include "reLed.h"
@@ -32,8 +37,16 @@
 static const char* logTAG = "ALARM";
 static const char* alarmTaskName = "alarm";
 
+// Internal inputs are stamped at ingestion, external ones (RX433 driver) at dequeue
+typedef struct {
+  input_data_t data;
+  int64_t timestamp;
+} alarmInput_t;
+
 TaskHandle_t _alarmTask;
 QueueHandle_t _alarmQueue = nullptr;
+SemaphoreHandle_t _alarmQueueBell = nullptr;
+QueueSetHandle_t _alarmQueueSet = nullptr;
 ledQueue_t _ledRx433 = nullptr;
 ledQueue_t _ledAlarm = nullptr;
 ledQueue_t _buzzer = nullptr;
@@ -41,6 +54,7 @@ ledQueue_t _buzzer = nullptr;
 #define ALARM_QUEUE_ITEM_SIZE sizeof(input_data_t)
 #if CONFIG_ALARM_STATIC_ALLOCATION
 StaticQueue_t _alarmQueueBuffer;
+StaticSemaphore_t _alarmQueueBellBuffer;
 StaticTask_t _alarmTaskBuffer;
 StackType_t _alarmTaskStack[CONFIG_ALARM_STACK_SIZE];
 uint8_t _alarmQueueStorage[CONFIG_ALARM_QUEUE_SIZE * ALARM_QUEUE_ITEM_SIZE];
@@ -50,33 +64,528 @@ uint8_t _alarmQueueStorage[CONFIG_ALARM_QUEUE_SIZE * ALARM_QUEUE_ITEM_SIZE];
 #define ERR_GPIO_SET_MODE "Failed to set GPIO mode"
 #define ERR_GPIO_SET_ISR  "Failed to set GPIO ISR handler"
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Statistics -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+static portMUX_TYPE _alarmStatsLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void alarmStatsHistogramAdd(alarmHistogram_t* hist, int64_t value)
+{
+  uint32_t us = value > 0 ? (value < UINT32_MAX ? (uint32_t)value : UINT32_MAX) : 0;
+  uint32_t bucket = us > 0 ? 32 - __builtin_clz(us) : 0;
+  if (bucket >= ALARM_STATS_BUCKETS) bucket = ALARM_STATS_BUCKETS - 1;
+  portENTER_CRITICAL(&_alarmStatsLock);
+  hist->count++;
+  hist->total += us;
+  if (us > hist->max) hist->max = us;
+  hist->buckets[bucket]++;
+  portEXIT_CRITICAL(&_alarmStatsLock);
+}
+
+static uint32_t alarmStatsHistogramPercentile(alarmHistogram_t* hist, uint8_t percentile)
+{
+  if ((hist->count == 0) || (percentile == 0)) return 0;
+  if (percentile > 100) percentile = 100;
+  uint64_t rank = ((uint64_t)hist->count * percentile + 99) / 100;
+  uint64_t total = 0;
+  for (uint8_t i = 0; i < ALARM_STATS_BUCKETS; i++) {
+    total += hist->buckets[i];
+    if (total >= rank) {
+      // Upper bound of bucket, but no more than the observed maximum
+      uint32_t bound = i > 0 ? (1U << i) : 0;
+      return bound < hist->max ? bound : hist->max;
+    };
+  };
+  return hist->max;
+}
+
+#if CONFIG_ALARM_LATENCY_ENABLE
+
+static alarmHistogram_t _alarmLatency[ALS_MAX];
+static int64_t _alarmLatencyOrigin = 0;
+
+static void alarmLatencyFix(alarm_latency_stage_t stage, int64_t origin)
+{
+  if (origin > 0) {
+    alarmStatsHistogramAdd(&_alarmLatency[stage], esp_timer_get_time() - origin);
+  };
+}
+
+// Stages of actuators and notifications are measured from the input being processed right now
+static void alarmLatencyFixCurrent(alarm_latency_stage_t stage)
+{
+  alarmLatencyFix(stage, _alarmLatencyOrigin);
+}
+
+uint32_t alarmLatencyPercentile(alarm_latency_stage_t stage, uint8_t percentile)
+{
+  alarmHistogram_t hist;
+  alarmLatencyGet(stage, &hist);
+  return alarmStatsHistogramPercentile(&hist, percentile);
+}
+
+void alarmLatencyGet(alarm_latency_stage_t stage, alarmHistogram_t* hist)
+{
+  if (hist) {
+    portENTER_CRITICAL(&_alarmStatsLock);
+    if (stage < ALS_MAX) {
+      memcpy(hist, &_alarmLatency[stage], sizeof(alarmHistogram_t));
+    } else {
+      memset(hist, 0, sizeof(alarmHistogram_t));
+    };
+    portEXIT_CRITICAL(&_alarmStatsLock);
+  };
+}
+
+static void alarmLatencyReset()
+{
+  portENTER_CRITICAL(&_alarmStatsLock);
+  memset(&_alarmLatency, 0, sizeof(_alarmLatency));
+  portEXIT_CRITICAL(&_alarmStatsLock);
+}
+
+#else
+
+static int64_t _alarmLatencyOrigin = 0;
+static inline void alarmLatencyFix(alarm_latency_stage_t stage, int64_t origin) {}
+static inline void alarmLatencyFixCurrent(alarm_latency_stage_t stage) {}
+static inline void alarmLatencyReset() {}
+uint32_t alarmLatencyPercentile(alarm_latency_stage_t stage, uint8_t percentile) { return 0; }
+void alarmLatencyGet(alarm_latency_stage_t stage, alarmHistogram_t* hist) { if (hist) memset(hist, 0, sizeof(alarmHistogram_t)); }
+
+#endif // CONFIG_ALARM_LATENCY_ENABLE
+
+#if CONFIG_ALARM_STATS_ENABLE
+
+static alarmStats_t _alarmStats;
+static int64_t _alarmStatsReceived = 0;
+static time_t _alarmStatsNext = 0;
+
+#define ALARM_STATS_INC(field) _alarmStats.field++
+#define ALARM_STATS_ADD(field, value) _alarmStats.field += value
+#define ALARM_STATS_START(var) int64_t var = esp_timer_get_time()
+#define ALARM_STATS_STOP(hist, var) alarmStatsHistogramAdd(&_alarmStats.hist, esp_timer_get_time() - var)
+
+static void alarmStatsFrame(source_type_t source)
+{
+  switch (source) {
+    case IDS_GPIO:  _alarmStats.frames_gpio++;  break;
+    case IDS_RX433: _alarmStats.frames_rx433++; break;
+    case IDS_MQTT:  _alarmStats.frames_mqtt++;  break;
+    default: break;
+  };
+}
+
+static void alarmStatsQueue(alarm_queue_class_t qclass)
+{
+  _alarmStatsReceived = esp_timer_get_time();
+  uint32_t waiting = 1;
+  for (uint8_t i = 0; i < AQC_MAX; i++) {
+    uint32_t depth = alarmQueueDepth((alarm_queue_class_t)i) + (i == qclass ? 1 : 0);
+    if (depth > _alarmStats.queue_class_hwm[i]) {
+      _alarmStats.queue_class_hwm[i] = depth;
+    };
+    waiting += depth - (i == qclass ? 1 : 0);
+  };
+  if (waiting > _alarmStats.queue_hwm) {
+    _alarmStats.queue_hwm = waiting;
+  };
+}
+
+static void alarmStatsSiren()
+{
+  if (_alarmStatsReceived > 0) {
+    alarmStatsHistogramAdd(&_alarmStats.siren, esp_timer_get_time() - _alarmStatsReceived);
+  };
+}
+
+void alarmStatsGet(alarmStats_t* stats)
+{
+  if (stats) {
+    portENTER_CRITICAL(&_alarmStatsLock);
+    memcpy(stats, &_alarmStats, sizeof(alarmStats_t));
+    portEXIT_CRITICAL(&_alarmStatsLock);
+  };
+}
+
+void alarmStatsReset()
+{
+  portENTER_CRITICAL(&_alarmStatsLock);
+  memset(&_alarmStats, 0, sizeof(alarmStats_t));
+  portEXIT_CRITICAL(&_alarmStatsLock);
+  alarmLatencyReset();
+}
+
+static char* alarmStatsJsonHistogram(const char* name, alarmHistogram_t* hist)
+{
+  char buckets[ALARM_STATS_BUCKETS * 11];
+  size_t len = 0;
+  buckets[0] = '\0';
+  for (uint8_t i = 0; i < ALARM_STATS_BUCKETS; i++) {
+    len += snprintf(buckets + len, sizeof(buckets) - len, i > 0 ? ",%u" : "%u", hist->buckets[i]);
+  };
+  return malloc_stringf("\"%s\":{\"count\":%u,\"max\":%u,\"avg\":%u,\"buckets\":[%s]}",
+    name, hist->count, hist->max, hist->count > 0 ? (uint32_t)(hist->total / hist->count) : 0, buckets);
+}
+
+static char* alarmStatsJsonLatency()
+{
+  static const char* stages[ALS_MAX] = { "dequeue", "match", "decision", "siren", "flasher", "buzzer", "mqtt", "telegram" };
+  char* json = nullptr;
+  char* temp = nullptr;
+  for (uint8_t i = 0; i < ALS_MAX; i++) {
+    temp = json;
+    json = malloc_stringf("%s%s\"%s\":{\"p50\":%u,\"p90\":%u,\"p99\":%u}", 
+      temp ? temp : "", temp ? "," : "", stages[i],
+      alarmLatencyPercentile((alarm_latency_stage_t)i, 50), 
+      alarmLatencyPercentile((alarm_latency_stage_t)i, 90), 
+      alarmLatencyPercentile((alarm_latency_stage_t)i, 99));
+    if (temp) free(temp);
+    if (!json) break;
+  };
+  return json;
+}
+
+static void alarmStatsPublish()
+{
+  if ((CONFIG_ALARM_STATS_INTERVAL > 0) && (time(nullptr) >= _alarmStatsNext) && esp_heap_free_check() && statesMqttIsEnabled()) {
+    _alarmStatsNext = time(nullptr) + CONFIG_ALARM_STATS_INTERVAL;
+
+    alarmStats_t stats;
+    alarmStatsGet(&stats);
+    char* topic = mqttGetTopicSpecial2(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_STATS_LOCAL, 
+      CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_STATS_TOPIC, CONFIG_ALARM_MQTT_STATUS_TOPIC);
+    char* jsonResponses = alarmStatsJsonHistogram("responses", &stats.responses);
+    char* jsonMqtt = alarmStatsJsonHistogram("mqtt", &stats.mqtt);
+    char* jsonTelegram = alarmStatsJsonHistogram("telegram", &stats.telegram);
+    char* jsonSiren = alarmStatsJsonHistogram("siren", &stats.siren);
+    char* jsonLatency = alarmStatsJsonLatency();
+    if (topic && jsonResponses && jsonMqtt && jsonTelegram && jsonSiren && jsonLatency) {
+      mqttPublish(topic, 
+        malloc_stringf("{\"frames\":{\"gpio\":%u,\"rx433\":%u,\"mqtt\":%u,\"matched\":%u,\"unmatched\":%u,\"dropped\":%u,\"filtered\":%u,\"replayed\":%u},\"queue_hwm\":%u,\"queues\":{\"alarm\":%u,\"control\":%u,\"bulk\":%u,\"bulk_dropped\":%u},\"effects_overflow\":%u,\"timers\":{\"created\":%u,\"failed\":%u},%s,%s,%s,%s,\"latency\":{%s}}",
+          stats.frames_gpio, stats.frames_rx433, stats.frames_mqtt, stats.frames_matched, stats.frames_unmatched, stats.frames_dropped, stats.frames_filtered, stats.frames_replayed,
+          stats.queue_hwm, stats.queue_class_hwm[AQC_ALARM], stats.queue_class_hwm[AQC_CONTROL], stats.queue_class_hwm[AQC_BULK], stats.queue_bulk_dropped,
+          stats.effects_overflow, stats.timers_created, stats.timers_failed, 
+          jsonResponses, jsonMqtt, jsonTelegram, jsonSiren, jsonLatency),
+        CONFIG_ALARM_MQTT_STATS_QOS, CONFIG_ALARM_MQTT_STATS_RETAINED, true, true);
+      topic = nullptr;
+    };
+    if (topic) free(topic);
+    if (jsonResponses) free(jsonResponses);
+    if (jsonMqtt) free(jsonMqtt);
+    if (jsonTelegram) free(jsonTelegram);
+    if (jsonSiren) free(jsonSiren);
+    if (jsonLatency) free(jsonLatency);
+  };
+}
+
+#else
+
+#define ALARM_STATS_INC(field) 
+#define ALARM_STATS_ADD(field, value) 
+#define ALARM_STATS_START(var) 
+#define ALARM_STATS_STOP(hist, var) 
+
+static inline void alarmStatsFrame(source_type_t source) {}
+static inline void alarmStatsQueue(alarm_queue_class_t qclass) {}
+static inline void alarmStatsSiren() {}
+static inline void alarmStatsPublish() {}
+void alarmStatsGet(alarmStats_t* stats) { if (stats) memset(stats, 0, sizeof(alarmStats_t)); }
+void alarmStatsReset() { alarmLatencyReset(); }
+
+#endif // CONFIG_ALARM_STATS_ENABLE
+
+static esp_err_t alarmTimerCreate(const esp_timer_create_args_t* args, esp_timer_handle_t* handle)
+{
+  esp_err_t err = esp_timer_create(args, handle);
+  if (err == ESP_OK) {
+    ALARM_STATS_INC(timers_created);
+  } else {
+    ALARM_STATS_INC(timers_failed);
+  };
+  return err;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Input queues -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Internal inputs are split into rings by class: wired inputs are never dropped, external values displace the oldest ones.
+ * RX433 packets (control class) come through the queue of the receiver driver. The rings only ring the bell of the queue set,
+ * the task always takes the classes in order of priority
+ * */
+
+typedef struct {
+  alarmInput_t* items;
+  uint32_t size;
+  uint32_t head;
+  uint32_t tail;
+} alarmRing_t;
+
+static alarmInput_t _alarmRingAlarmItems[CONFIG_ALARM_QUEUE_SIZE];
+static alarmInput_t _alarmRingBulkItems[CONFIG_ALARM_QUEUE_BULK_SIZE];
+static alarmRing_t _alarmRingAlarm = { _alarmRingAlarmItems, CONFIG_ALARM_QUEUE_SIZE, 0, 0 };
+static alarmRing_t _alarmRingBulk = { _alarmRingBulkItems, CONFIG_ALARM_QUEUE_BULK_SIZE, 0, 0 };
+static portMUX_TYPE _alarmRingLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Must be called inside the ring lock
+static bool alarmRingPushLocked(alarmRing_t* ring, const alarmInput_t* input, bool displace)
+{
+  if ((ring->head - ring->tail) >= ring->size) {
+    if (!displace) return false;
+    ring->tail++;
+    ALARM_STATS_INC(queue_bulk_dropped);
+  };
+  ring->items[ring->head % ring->size] = *input;
+  ring->head++;
+  return true;
+}
+
+static bool alarmRingPush(alarmRing_t* ring, const alarmInput_t* input, bool displace)
+{
+  portENTER_CRITICAL(&_alarmRingLock);
+  bool ret = alarmRingPushLocked(ring, input, displace);
+  portEXIT_CRITICAL(&_alarmRingLock);
+  return ret;
+}
+
+static bool alarmRingPop(alarmRing_t* ring, alarmInput_t* input)
+{
+  bool ret = false;
+  portENTER_CRITICAL(&_alarmRingLock);
+  if (ring->head != ring->tail) {
+    *input = ring->items[ring->tail % ring->size];
+    ring->tail++;
+    ret = true;
+  };
+  portEXIT_CRITICAL(&_alarmRingLock);
+  return ret;
+}
+
+uint32_t alarmQueueDepth(alarm_queue_class_t qclass)
+{
+  switch (qclass) {
+    case AQC_ALARM:
+      return _alarmRingAlarm.head - _alarmRingAlarm.tail;
+    case AQC_CONTROL:
+      return _alarmQueue ? uxQueueMessagesWaiting(_alarmQueue) : 0;
+    case AQC_BULK:
+      return _alarmRingBulk.head - _alarmRingBulk.tail;
+    default:
+      return 0;
+  };
+}
+
+// Puts an internal input into the queue of its class
+static bool alarmQueuePost(const alarmInput_t* input)
+{
+  if (!_alarmQueueBell) return false;
+  if (input->data.source == IDS_RX433) {
+    return xQueueSend(_alarmQueue, &input->data, portMAX_DELAY) == pdPASS;
+  } else if (input->data.source == IDS_GPIO) {
+    // Wired inputs are never dropped: wait for the task to free up space
+    while (!alarmRingPush(&_alarmRingAlarm, input, false)) {
+      vTaskDelay(1);
+    };
+  } else {
+    alarmRingPush(&_alarmRingBulk, input, true);
+  };
+  xSemaphoreGive(_alarmQueueBell);
+  return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------ Timestamps -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * The same few seconds are formatted over and over (status, events, zones, notifications), so the last formatted values
+ * are kept in a small shared cache. Within the cached minute only the seconds of the broken-down time are replaced and
+ * localtime_r() is skipped. Results are copied into a context owned by the caller, so any task may call the formatter
+ * */
+
+typedef struct {
+  time_t value;
+  char ts_unix[CONFIG_BUFFER_LEN_INT64_RADIX10];
+  char ts_long[CONFIG_ALARM_TIMESTAMP_LONG_BUF_SIZE];
+  char ts_short[CONFIG_ALARM_TIMESTAMP_SHORT_BUF_SIZE];
+  char ts_dts[CONFIG_FORMAT_STRFTIME_DTS_BUFFER_SIZE];
+} alarmTimestamp_t;
+
+static alarmTimestamp_t _alarmTimestampCache[CONFIG_ALARM_TIMESTAMP_CACHE_SIZE];
+static uint8_t _alarmTimestampNext = 0;
+static time_t _alarmTimestampMinute = 0;
+static struct tm _alarmTimestampTm;
+static portMUX_TYPE _alarmTimestampLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void alarmFormatTimestamp(time_t value, alarmTimestamp_t* ts)
+{
+  ts->value = value;
+  if (value <= 0) {
+    strcpy(ts->ts_unix, "0");
+    strcpy(ts->ts_long, CONFIG_FORMAT_EMPTY_DATETIME);
+    strcpy(ts->ts_short, CONFIG_FORMAT_EMPTY_DATETIME);
+    strcpy(ts->ts_dts, CONFIG_FORMAT_EMPTY_DATETIME);
+    return;
+  };
+
+  // Look up the cache and the broken-down time of the current minute
+  struct tm timeinfo;
+  time_t minute = value - (value % 60);
+  bool found = false;
+  bool same_minute = false;
+  portENTER_CRITICAL(&_alarmTimestampLock);
+  for (uint8_t i = 0; i < CONFIG_ALARM_TIMESTAMP_CACHE_SIZE; i++) {
+    if (_alarmTimestampCache[i].value == value) {
+      *ts = _alarmTimestampCache[i];
+      found = true;
+      break;
+    };
+  };
+  if (!found && (_alarmTimestampMinute == minute)) {
+    timeinfo = _alarmTimestampTm;
+    same_minute = true;
+  };
+  portEXIT_CRITICAL(&_alarmTimestampLock);
+  if (found) return;
+
+  // Format outside the lock
+  if (same_minute) {
+    timeinfo.tm_sec = value % 60;
+  } else {
+    localtime_r(&value, &timeinfo);
+  };
+  _ui64toa(value, ts->ts_unix, 10);
+  strftime(ts->ts_long, sizeof(ts->ts_long), CONFIG_ALARM_TIMESTAMP_LONG, &timeinfo);
+  strftime(ts->ts_short, sizeof(ts->ts_short), CONFIG_ALARM_TIMESTAMP_SHORT, &timeinfo);
+  strftime(ts->ts_dts, sizeof(ts->ts_dts), CONFIG_FORMAT_DTS, &timeinfo);
+
+  portENTER_CRITICAL(&_alarmTimestampLock);
+  _alarmTimestampCache[_alarmTimestampNext] = *ts;
+  _alarmTimestampNext = (_alarmTimestampNext + 1) % CONFIG_ALARM_TIMESTAMP_CACHE_SIZE;
+  if (!same_minute) {
+    _alarmTimestampMinute = minute;
+    _alarmTimestampTm = timeinfo;
+  };
+  portEXIT_CRITICAL(&_alarmTimestampLock);
+}
+
+// Local hour of the day, -1 if the time is not set yet. Uses the broken-down time of the cached minute when possible
+static int alarmTimestampHour(time_t value)
+{
+  time_t minute = value - (value % 60);
+  struct tm timeinfo;
+  bool same_minute = false;
+  portENTER_CRITICAL(&_alarmTimestampLock);
+  if (_alarmTimestampMinute == minute) {
+    timeinfo = _alarmTimestampTm;
+    same_minute = true;
+  };
+  portEXIT_CRITICAL(&_alarmTimestampLock);
+  if (!same_minute) {
+    localtime_r(&value, &timeinfo);
+    portENTER_CRITICAL(&_alarmTimestampLock);
+    _alarmTimestampMinute = minute;
+    _alarmTimestampTm = timeinfo;
+    portEXIT_CRITICAL(&_alarmTimestampLock);
+  };
+  return (timeinfo.tm_year < 100) ? -1 : timeinfo.tm_hour;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------
 // ------------------------------------------------------ Modes ----------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-static alarm_mode_t _alarmMode = ASM_DISABLED;
-static paramsEntryHandle_t _alarmParamMode = nullptr;
+typedef struct alarmPartition_t {
+  const char* name;
+  const char* topic;
+  alarm_mode_t mode;
+  uint32_t count;
+  alarm_siren_policy_t siren_policy;
+  uint16_t exits;                         // Number of zones with a running exit delay
+  bool annunciator;                       // The siren or flasher is held by the alarm of this partition
+  time_t last_event;
+  time_t last_alarm;
+  alarmEventData_t last_event_data;
+  alarmEventData_t last_alarm_data;
+  paramsEntryHandle_t param_mode;
+  STAILQ_ENTRY(alarmPartition_t) next;
+} alarmPartition_t;
+
+STAILQ_HEAD(alarmPartitionHead_t, alarmPartition_t);
+typedef struct alarmPartitionHead_t *alarmPartitionHeadHandle_t;
+
+// The main partition owns all zones by default, its mode is stored in the "mode" parameter as before
+static alarmPartition_t _alarmPartMain = {CONFIG_ALARM_PARTITION_MAIN_NAME, nullptr, ASM_DISABLED, 0, ASP_SIREN, 0, 
+  false, 0, 0, {nullptr, nullptr, 0}, {nullptr, nullptr, 0}, nullptr, {nullptr}};
+static alarmPartitionHeadHandle_t _alarmPartitions = nullptr;
+
 static cb_alarm_change_mode_t _alarmOnChangeMode = nullptr;
 static bool _alarmStoreUnknownRx433Codes = false;
-static uint32_t _alarmCount = 0;
-static time_t _alarmLastEvent = 0;
-static time_t _alarmLastAlarm = 0;
-static alarmEventData_t _alarmLastEventData = {nullptr, nullptr};
-static alarmEventData_t _alarmLastAlarmData = {nullptr, nullptr};
+static uint8_t _alarmLogFrames = CONFIG_ALARM_LOG_FRAMES;
 static uint16_t _alarmExitTime = CONFIG_ALARM_EXIT_TIME;
-static bool _alarmExitLock = false;
-static esp_timer_handle_t _timerExit = nullptr;
 
-static void alarmAlarmsReset(const char* source);
-static void alarmSensorsReset();
+static void alarmAlarmsReset(alarmPartitionHandle_t partition, const char* source);
+static void alarmSensorsReset(alarmPartitionHandle_t partition);
 static void alarmBuzzerAlarmOff();
 static void alarmSirenAlarmOff(bool forced);
 static void alarmFlasherAlarmOff(bool forced);
-static void alarmSirenChangeMode();
+static bool alarmAnnunciatorRelease(alarmPartitionHandle_t partition);
+static void alarmSirenChangeMode(alarmPartitionHandle_t partition);
 static void alarmFlasherChangeMode();
-static void alarmBuzzerChangeMode();
-static void alarmMqttPublishEvent(alarmEventData_t event_data, bool publish_local);
+static void alarmBuzzerChangeMode(alarmPartitionHandle_t partition);
+// Values of an event copied by the alarm task at the moment of posting, they are published later by another task
+typedef struct {
+  const char* zone_topic;
+  const char* sensor_topic;
+  const char* msg;
+  alarm_event_t type;
+  bool state;
+  bool publish_local;
+  uint32_t events_count;
+  time_t event_last;
+  int64_t timestamp;
+} alarmEventValues_t;
+
+// Status of a partition copied by the alarm task at the moment of posting; zone values are copied into the zones
+typedef struct {
+  alarmPartitionHandle_t partition;
+  alarm_mode_t mode;
+  uint32_t count;
+  bool annunciator;               // The siren and flasher states belong to this partition
+  bool siren;
+  bool flasher;
+  time_t last_event;
+  time_t last_alarm;
+  alarmSensorHandle_t last_event_sensor;
+  alarmSensorHandle_t last_alarm_sensor;
+} alarmStatusValues_t;
+
+static void alarmMqttPublishEvent(const alarmEventValues_t* values);
+static void alarmMqttPublishStatusValues(const alarmStatusValues_t* values);
+static void alarmMqttPublishPartitionValues(const alarmStatusValues_t* values);
 static void alarmMqttPublishStatus();
+static void alarmMqttPublishPartition(alarmPartitionHandle_t partition);
+static uint16_t alarmZonesExitStart(alarmPartitionHandle_t partition);
+static void alarmZonesDelaysCancel(alarmPartitionHandle_t partition);
+static void alarmMqttPublishPartitions();
+static void alarmBypassDisarm(alarmPartitionHandle_t partition);
+static void alarmSnapshotUpdate();
+static void alarmWebNotify();
+static void alarmCommandsInit();
+
+static bool alarmPartitionsInit()
+{
+  if (!_alarmPartitions) {
+    _alarmPartitions = (alarmPartitionHeadHandle_t)esp_calloc(1, sizeof(alarmPartitionHead_t));
+    RE_MEM_CHECK(_alarmPartitions, return false);
+    STAILQ_INIT(_alarmPartitions);
+    STAILQ_INSERT_TAIL(_alarmPartitions, &_alarmPartMain, next);
+  };
+  return true;
+}
 
 static const char* alarmModeText(alarm_mode_t mode) 
 {
@@ -112,108 +621,95 @@ static const char* alarmSourceText(alarm_control_t source, const char* sensor)
   };
 }
 
-static void alarmTimerExitFree()
+static void alarmModeChangePartition(alarmPartitionHandle_t partition, alarm_control_t source, const char* sensor)
 {
-  if (_timerExit != nullptr) {
-    if (esp_timer_is_active(_timerExit)) {
-      ERR_CHECK(esp_timer_stop(_timerExit), "Failed to stop timer of exit");
-    };
-    ERR_CHECK(esp_timer_delete(_timerExit), "Failed to free timer of exit");
-    _timerExit = nullptr;
-  };
-}
-
-static void alarmTimerExitEnd(void* arg)
-{ 
-  if (_alarmExitLock) {
-    _alarmExitLock = false;
-
-    #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
-      tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_MODE_CHANGE, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_MODE_CHANGE, 
-        CONFIG_TELEGRAM_DEVICE, CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_ACTIVATED);
-    #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
+  uint16_t exitDelay = 0;
+  rlog_w(logTAG, "Partition [ %s ]: security mode %d activated", partition->name, partition->mode);
+  eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_PARTITION_MODE, &partition, sizeof(alarmPartitionHandle_t), portMAX_DELAY);
+  if ((partition->mode == ASM_ARMED) && ((source == ACC_BUTTONS) || (source == ACC_RCONTROL))) {
+    exitDelay = alarmZonesExitStart(partition);
   };
-
-  alarmTimerExitFree();
-}
-
-static bool alarmTimerExitStart()
-{
-  _alarmExitLock = false;
-  if (_alarmExitTime > 0) {
-    if (_timerExit == nullptr) {
-      esp_timer_create_args_t timer_args;
-      memset(&timer_args, 0, sizeof(esp_timer_create_args_t));
-      timer_args.callback = &alarmTimerExitEnd;
-      timer_args.name = "timer_exit";
-      ERR_CHECK(esp_timer_create(&timer_args, &_timerExit), "Failed to create timer of exit");
-    };
-    // If timer already started, stop it
-    if (_timerExit) {
-      if (esp_timer_is_active(_timerExit)) {
-        esp_timer_stop(_timerExit);
-      };
-      // Start once
-      _alarmExitLock = (esp_timer_start_once(_timerExit, (uint64_t)_alarmExitTime * 1000000) == ESP_OK);
-      if (!_alarmExitLock) {
-        rlog_e(logTAG, "Failed to start timer of exit");
-      };
-    };
+  #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
+    tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_MODE_CHANGE, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_MODE_CHANGE, CONFIG_TELEGRAM_DEVICE, 
+      CONFIG_NOTIFY_TELEGRAM_ALARM_PARTITION_MODE, partition->name, alarmModeText(partition->mode), alarmSourceText(source, sensor));
+  #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
+  if (exitDelay > 0) {
+    rlog_i(logTAG, "Partition [ %s ]: exit delay %d s", partition->name, exitDelay);
   };
-  return _alarmExitLock;
 }
 
-static void alarmModeChange(alarm_mode_t new_mode, alarm_control_t source, const char* sensor, bool forced, bool publish_status)
+static void alarmModeChange(alarmPartitionHandle_t partition, alarm_mode_t new_mode, alarm_control_t source, const char* sensor, bool forced, bool publish_status)
 {
-  rlog_d(logTAG, "Change security mode: source=%d, new mode=%d, curr mode=%d, forced=%d, sensor=%s", 
-    source, new_mode, _alarmMode, forced, (sensor != nullptr) ? sensor : "null");
+  rlog_d(logTAG, "Change security mode: partition=%s, source=%d, new mode=%d, curr mode=%d, forced=%d, sensor=%s", 
+    partition->name, source, new_mode, partition->mode, forced, (sensor != nullptr) ? sensor : "null");
 
-  bool alarmModeChanged = new_mode != _alarmMode;
+  bool isMain = partition == &_alarmPartMain;
+  bool alarmModeChanged = new_mode != partition->mode;
   if (forced || alarmModeChanged) {
     // Store and publish new value
-    if (_alarmParamMode) {
+    if (partition->param_mode) {
       if (alarmModeChanged) {
-        _alarmMode = new_mode;
-        paramsValueStore(_alarmParamMode, false);
+        partition->mode = new_mode;
+        paramsValueStore(partition->param_mode, false);
       } else {
-        paramsMqttPublish(_alarmParamMode, true);
+        paramsMqttPublish(partition->param_mode, true);
       };
     };
 
+    // Any mode change cancels running entry and exit delays of the partition
+    uint16_t exitDelay = 0;
+    alarmZonesDelaysCancel(partition);
+
     // Reset counters
     if (new_mode != ASM_DISABLED) {
-      alarmAlarmsReset(nullptr);
+      alarmAlarmsReset(partition, nullptr);
     };
 
-    // Disable siren if ASM_DISABLED mode is set
+    // Disarming removes temporary bypasses of the partition zones
     if (new_mode == ASM_DISABLED) {
+      alarmBypassDisarm(partition);
+    };
+
+    // Disable siren if ASM_DISABLED mode is set (only if no other partition holds it)
+    if ((new_mode == ASM_DISABLED) && alarmAnnunciatorRelease(partition)) {
       alarmSirenAlarmOff(true);
       alarmFlasherAlarmOff(false);
     };
 
-    // One-time siren signal when switching the arming mode
-    alarmFlasherChangeMode();
+    // One-time siren signal when switching the arming mode, the flasher displays the mode of the main partition
+    if (isMain) {
+      alarmFlasherChangeMode();
+    };
     if ((source == ACC_BUTTONS) || (source == ACC_RCONTROL)) {
-      alarmSirenChangeMode();
-      alarmBuzzerChangeMode();
+      alarmSirenChangeMode(partition);
+      alarmBuzzerChangeMode(partition);
     };
     
     // Publish current mode and status on MQTT broker
     if (publish_status) {
-      alarmMqttPublishStatus();
+      alarmMqttPublishPartition(partition);
+    };
+
+    // Notifications for additional partitions
+    if (!isMain) {
+      alarmModeChangePartition(partition, source, sensor);
+      if (_alarmOnChangeMode) {
+        _alarmOnChangeMode(partition->mode, source);
+      };
+      return;
     };
 
     // Notifications
-    switch (_alarmMode) {
+    switch (partition->mode) {
       // Security mode is on
       case ASM_ARMED:
         rlog_w(logTAG, "Full security mode activated");
         eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_MODE_ARMED, &source, sizeof(alarm_control_t), portMAX_DELAY);
         // Start exit timer, if enabled
-        if (((source == ACC_BUTTONS) || (source == ACC_RCONTROL)) && alarmTimerExitStart()) {
+        if (((source == ACC_BUTTONS) || (source == ACC_RCONTROL)) && ((exitDelay = alarmZonesExitStart(partition)) > 0)) {
           #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
             tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_MODE_CHANGE, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_MODE_CHANGE, CONFIG_TELEGRAM_DEVICE, 
-              CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_ARMED_DELAYED, _alarmExitTime, alarmSourceText(source, sensor));
+              CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_ARMED_DELAYED, exitDelay, alarmSourceText(source, sensor));
           #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
         } else {
           #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
@@ -246,7 +742,6 @@ static void alarmModeChange(alarm_mode_t new_mode, alarm_control_t source, const
       // Security mode disabled
       default:
         rlog_w(logTAG, "Security mode disabled");
-        alarmTimerExitFree();
         eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_MODE_DISABLED, &source, sizeof(alarm_control_t), portMAX_DELAY);
         #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
           tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_MODE_CHANGE, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_MODE_CHANGE, CONFIG_TELEGRAM_DEVICE, 
@@ -257,7 +752,7 @@ static void alarmModeChange(alarm_mode_t new_mode, alarm_control_t source, const
     
     // Callback
     if (_alarmOnChangeMode) {
-      _alarmOnChangeMode(_alarmMode, source);
+      _alarmOnChangeMode(partition->mode, source);
     };
   };
 }
@@ -268,11 +763,11 @@ static void alarmModeChange(alarm_mode_t new_mode, alarm_control_t source, const
 
 static bool _alarmBuzzerEnabled = true;
 
-static void alarmBuzzerChangeMode()
+static void alarmBuzzerChangeMode(alarmPartitionHandle_t partition)
 {
   if (_alarmBuzzerEnabled) {
-    if (_alarmMode == ASM_DISABLED) {
-      if (_alarmCount > 0) {
+    if (partition->mode == ASM_DISABLED) {
+      if (partition->count > 0) {
         if (_buzzer) {
           ledTaskSend(_buzzer, lmFlash, 
             CONFIG_ALARM_BUZZER_DISABLED_WARNING_QUANTITY,
@@ -301,7 +796,7 @@ static void alarmBuzzerChangeMode()
           #endif // CONFIG_GPIO_BUZZER
         };
       };
-    } else if (_alarmMode == ASM_ARMED) {
+    } else if (partition->mode == ASM_ARMED) {
       if (_buzzer) {
         ledTaskSend(_buzzer, lmFlash, 
           CONFIG_ALARM_BUZZER_ARMED_QUANTITY,
@@ -336,6 +831,7 @@ static void alarmBuzzerChangeMode()
 static void alarmBuzzerAlarmOn()
 {
   if (_alarmBuzzerEnabled) {
+    alarmLatencyFixCurrent(ALS_BUZZER);
     if (_buzzer) {
       ledTaskSend(_buzzer, lmFlash, 
         CONFIG_ALARM_BUZZER_ALARM_QUANTITY,
@@ -393,7 +889,7 @@ static bool alarmFlasherTimerCreate()
     memset(&flasher_timer_args, 0, sizeof(esp_timer_create_args_t));
     flasher_timer_args.callback = &alarmFlasherTimerEnd;
     flasher_timer_args.name = "timer_flasher";
-    ERR_CHECK(esp_timer_create(&flasher_timer_args, &_flasherTimer), "Failed to create flasher timer");
+    ERR_CHECK(alarmTimerCreate(&flasher_timer_args, &_flasherTimer), "Failed to create flasher timer");
     return true;
   };
   return false;
@@ -452,22 +948,22 @@ static void alarmFlasherChangeMode()
     eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_FLASHER_ON, nullptr, 0, portMAX_DELAY);
     alarmFlasherBlinkOn(CONFIG_ALARM_ALARM_QUANTITY, CONFIG_ALARM_ALARM_DURATION, CONFIG_ALARM_ALARM_INTERVAL);
   } else {
-    if (_alarmMode == ASM_DISABLED) {
+    if (_alarmPartMain.mode == ASM_DISABLED) {
       rlog_d(logTAG, "Flasher disabled");
       // Security is fully disabled
       eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_FLASHER_OFF, nullptr, 0, portMAX_DELAY);
       alarmFlasherBlinkOn(0, 0, 0);
       vTaskDelay(10);
-      if (_alarmCount > 0) {
+      if (_alarmPartMain.count > 0) {
         alarmFlasherFlashOn(CONFIG_ALARM_SIREN_DISABLED_WARNING_QUANTITY, CONFIG_ALARM_SIREN_DISABLED_WARNING_DURATION, CONFIG_ALARM_SIREN_DISABLED_WARNING_INTERVAL);
       } else {
         alarmFlasherFlashOn(CONFIG_ALARM_SIREN_DISABLED_NORMAL_QUANTITY, CONFIG_ALARM_SIREN_DISABLED_NORMAL_DURATION, CONFIG_ALARM_SIREN_DISABLED_NORMAL_INTERVAL);
       };
-    } else if (_alarmMode == ASM_ARMED) {
+    } else if (_alarmPartMain.mode == ASM_ARMED) {
       rlog_d(logTAG, "Flasher set fully armed");
       // Security is active
       eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_FLASHER_BLINK, nullptr, 0, portMAX_DELAY);
-      if (_alarmCount == 0) {
+      if (_alarmPartMain.count == 0) {
         // All is calm, all is well
         alarmFlasherBlinkOn(CONFIG_ALARM_ARMED_QUANTITY, CONFIG_ALARM_ARMED_DURATION, CONFIG_ALARM_ARMED_INTERVAL);
         vTaskDelay(10);
@@ -494,6 +990,7 @@ static void alarmFlasherAlarmOn()
   if (!_flasherActive && alarmFlasherTimerStart()) {
     _flasherActive = true;
     alarmFlasherChangeMode();
+    alarmLatencyFixCurrent(ALS_FLASHER);
   };
 }
 
@@ -512,6 +1009,7 @@ static void alarmFlasherAlarmOff(bool forced)
 
 ledQueue_t _siren = nullptr;
 static uint32_t _sirenDuration = CONFIG_ALARM_DURATION_SIREN;
+static paramsEntryHandle_t _sirenDurationParam = nullptr;
 static esp_timer_handle_t _sirenTimer = nullptr;
 static bool _sirenActive = false;
 static bool _sirenSilentEnabled = false;
@@ -530,7 +1028,7 @@ static bool alarmSirenTimerCreate()
     memset(&siren_timer_args, 0, sizeof(esp_timer_create_args_t));
     siren_timer_args.callback = &alarmSirenTimerEnd;
     siren_timer_args.name = "timer_siren";
-    ERR_CHECK(esp_timer_create(&siren_timer_args, &_sirenTimer), "Failed to create siren timer");
+    ERR_CHECK(alarmTimerCreate(&siren_timer_args, &_sirenTimer), "Failed to create siren timer");
     return true;
   };
   return false;
@@ -560,8 +1058,10 @@ static void alarmSirenSwitch()
   if (_siren) {
     if (_sirenActive) {
       rlog_d(logTAG, "Siren activated");
-      eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_SIREN_ON, nullptr, 0, portMAX_DELAY);
       ledTaskSend(_siren, lmOn, 1, 0, 0);
+      alarmStatsSiren();
+      alarmLatencyFixCurrent(ALS_SIREN);
+      eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_SIREN_ON, nullptr, 0, portMAX_DELAY);
     } else {
       rlog_d(logTAG, "Siren disabled");
       eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_SIREN_OFF, nullptr, 0, portMAX_DELAY);
@@ -590,12 +1090,12 @@ static void alarmSirenAlarmOff(bool forced)
   };
 }
 
-static void alarmSirenChangeMode()
+static void alarmSirenChangeMode(alarmPartitionHandle_t partition)
 {
-  if (_siren) {
+  if (_siren && (partition->siren_policy == ASP_SIREN)) {
     ledTaskSend(_siren, lmOff, 1, 0, 0);
-    if (_alarmMode == ASM_DISABLED) {
-      if (_alarmCount > 0) {
+    if (partition->mode == ASM_DISABLED) {
+      if (partition->count > 0) {
         #if CONFIG_ALARM_SIREN_DISABLED_WARNING_QUANTITY > 0
           ledTaskSend(_siren, lmFlash, 
             CONFIG_ALARM_SIREN_DISABLED_WARNING_QUANTITY, 
@@ -617,7 +1117,7 @@ static void alarmSirenChangeMode()
             CONFIG_ALARM_SIREN_DISABLED_NORMAL_INTERVAL);
         #endif // CONFIG_ALARM_SIREN_DISABLED_NORMAL_QUANTITY
       };
-    } else if (_alarmMode == ASM_ARMED) {
+    } else if (partition->mode == ASM_ARMED) {
       #if CONFIG_ALARM_SIREN_ARMED_QUANTITY > 0
         ledTaskSend(_siren, lmFlash, 
           CONFIG_ALARM_SIREN_ARMED_QUANTITY, 
@@ -639,12 +1139,72 @@ static void alarmSirenChangeMode()
 // ------------------------------------------------------- Alarms --------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-static void alarmAlarmsReset(const char* source)
+// The siren and flasher are shared: each partition whose alarm turned them on holds them until it is disarmed or canceled.
+// A new alarm after the annunciators went off by timeout starts a new set of holders
+static void alarmAnnunciatorAcquire(alarmPartitionHandle_t partition)
+{
+  if (!_sirenActive && !_flasherActive && _alarmPartitions) {
+    alarmPartitionHandle_t item;
+    STAILQ_FOREACH(item, _alarmPartitions, next) {
+      item->annunciator = false;
+    };
+  };
+  partition->annunciator = true;
+}
+
+// Releases the annunciators held by the partition (nullptr or the main partition - by all partitions), 
+// returns true if they should be turned off
+static bool alarmAnnunciatorRelease(alarmPartitionHandle_t partition)
+{
+  bool all = !partition || (partition == &_alarmPartMain);
+  if (!all && !partition->annunciator) return false;
+  bool held = false;
+  if (_alarmPartitions) {
+    alarmPartitionHandle_t item;
+    STAILQ_FOREACH(item, _alarmPartitions, next) {
+      if (all || (item == partition)) {
+        item->annunciator = false;
+      } else if (item->annunciator) {
+        held = true;
+      };
+    };
+  } else {
+    _alarmPartMain.annunciator = false;
+  };
+  return all || !held;
+}
+
+// Resets counters of the specified partition, nullptr - of all partitions
+static void alarmPartitionsCountReset(alarmPartitionHandle_t partition)
+{
+  if (_alarmPartitions) {
+    alarmPartitionHandle_t item;
+    STAILQ_FOREACH(item, _alarmPartitions, next) {
+      if (!partition || (item == partition)) {
+        item->count = 0;
+      };
+    };
+  } else {
+    _alarmPartMain.count = 0;
+  };
+}
+
+static void alarmAlarmsReset(alarmPartitionHandle_t partition, const char* source)
 {
-  _alarmCount = 0;
-  _alarmLastAlarm = 0;
-  _alarmLastAlarmData = {nullptr, nullptr};
-  alarmSensorsReset();
+  alarmPartitionsCountReset(partition);
+  if (_alarmPartitions) {
+    alarmPartitionHandle_t item;
+    STAILQ_FOREACH(item, _alarmPartitions, next) {
+      if (!partition || (item == partition)) {
+        item->last_alarm = 0;
+        item->last_alarm_data = {nullptr, nullptr, 0};
+      };
+    };
+  } else {
+    _alarmPartMain.last_alarm = 0;
+    _alarmPartMain.last_alarm_data = {nullptr, nullptr, 0};
+  };
+  alarmSensorsReset(partition);
 
   #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
     if (source) {
@@ -654,13 +1214,17 @@ static void alarmAlarmsReset(const char* source)
   #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
 }
 
-static bool alarmAlarmCancel(const char* source)
+// Cancels the alarm of the specified partition, nullptr - of all partitions
+static bool alarmAlarmCancel(alarmPartitionHandle_t partition, const char* source)
 {
-  bool alarmCanceled = _sirenActive || _flasherActive;
+  bool alarmOwner = !partition || (partition == &_alarmPartMain) || partition->annunciator;
+  bool alarmCanceled = alarmOwner && (_sirenActive || _flasherActive);
 
-  _alarmCount = 0;
-  alarmSirenAlarmOff(true);
-  alarmFlasherAlarmOff(true);
+  alarmPartitionsCountReset(partition);
+  if (alarmAnnunciatorRelease(partition)) {
+    alarmSirenAlarmOff(true);
+    alarmFlasherAlarmOff(true);
+  };
   if (alarmCanceled) {
     alarmBuzzerAlarmOff();
   };
@@ -710,7 +1274,7 @@ static bool alarmConfirmationTimerStart()
     timer_args.callback = &alarmConfirmationTimerEnd;
     timer_args.name = "timer_alarm";
 
-    err = esp_timer_create(&timer_args, &alarmConfirmationTimer);
+    err = alarmTimerCreate(&timer_args, &alarmConfirmationTimer);
     if (err != ESP_OK) {
       rlog_e(logTAG, "Failed to create alarm confirmation timer!");
       return false;
@@ -744,6 +1308,161 @@ static bool alarmConfirmationCheck()
   return true;
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- Correlation rules ---------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+  alarmSensorHandle_t sensor;
+  int64_t time;
+} alarmRuleItem_t;
+
+typedef struct {
+  alarm_rule_type_t type;
+  uint32_t window;
+  uint8_t k;
+  alarmEventHandle_t first;   // ARL_SEQUENCE: A; ARL_UNLESS: X
+  alarmEventHandle_t second;  // ARL_SEQUENCE: B; ARL_UNLESS: Y
+  int64_t last;               // Time of the last A (ARL_SEQUENCE) or Y (ARL_UNLESS)
+  uint8_t head;
+  alarmRuleItem_t items[CONFIG_ALARM_RULE_WINDOW_SIZE];
+} alarmRule_t;
+
+static alarmRule_t _alarmRules[CONFIG_ALARM_MAX_RULES];
+static uint8_t _alarmRulesCount = 0;
+
+static int8_t alarmRuleAdd(alarm_rule_type_t type, uint32_t window_ms)
+{
+  if ((_alarmRulesCount >= CONFIG_ALARM_MAX_RULES) || (_alarmRulesCount >= 32)) {
+    rlog_e(logTAG, "Failed to add correlation rule: too many rules");
+    return -1;
+  };
+  alarmRule_t* rule = &_alarmRules[_alarmRulesCount];
+  memset(rule, 0, sizeof(alarmRule_t));
+  rule->type = type;
+  rule->window = window_ms;
+  return _alarmRulesCount++;
+}
+
+int8_t alarmRuleAddKofN(alarmZoneHandle_t zone, uint8_t k, uint32_t window_ms)
+{
+  if (!zone || (k == 0) || (k > CONFIG_ALARM_RULE_WINDOW_SIZE)) return -1;
+  int8_t index = alarmRuleAdd(ARL_K_OF_N, window_ms);
+  if (index >= 0) {
+    _alarmRules[index].k = k;
+    zone->rules |= (1UL << index);
+  };
+  return index;
+}
+
+int8_t alarmRuleAddSequence(alarmEventHandle_t first, alarmEventHandle_t second, uint32_t window_ms)
+{
+  if (!first || !second) return -1;
+  int8_t index = alarmRuleAdd(ARL_SEQUENCE, window_ms);
+  if (index >= 0) {
+    _alarmRules[index].first = first;
+    _alarmRules[index].second = second;
+    first->rules |= (1UL << index);
+    second->rules |= (1UL << index);
+  };
+  return index;
+}
+
+int8_t alarmRuleAddUnless(alarmEventHandle_t event, alarmEventHandle_t inhibitor, uint32_t window_ms)
+{
+  if (!event || !inhibitor) return -1;
+  int8_t index = alarmRuleAdd(ARL_UNLESS, window_ms);
+  if (index >= 0) {
+    _alarmRules[index].first = event;
+    _alarmRules[index].second = inhibitor;
+    event->rules |= (1UL << index);
+    inhibitor->rules |= (1UL << index);
+  };
+  return index;
+}
+
+// Adds the sensor to the rule window and counts distinct sensors within the window
+static bool alarmRuleKofN(alarmRule_t* rule, alarmSensorHandle_t sensor, int64_t now)
+{
+  rule->items[rule->head].sensor = sensor;
+  rule->items[rule->head].time = now;
+  rule->head = (rule->head + 1) % CONFIG_ALARM_RULE_WINDOW_SIZE;
+
+  alarmSensorHandle_t found[CONFIG_ALARM_RULE_WINDOW_SIZE];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < CONFIG_ALARM_RULE_WINDOW_SIZE; i++) {
+    alarmRuleItem_t* item = &rule->items[i];
+    if (item->sensor && ((now - item->time) <= rule->window)) {
+      bool unique = true;
+      for (uint8_t j = 0; j < count; j++) {
+        if (found[j] == item->sensor) {
+          unique = false;
+          break;
+        };
+      };
+      if (unique) {
+        found[count++] = item->sensor;
+        if (count >= rule->k) return true;
+      };
+    };
+  };
+  return false;
+}
+
+// Evaluates only the rules linked to the event or its zone; without rules the global confirmation timer is used.
+// A veto of ARL_UNLESS is not an unconfirmed alarm: the alarm is suppressed and its responses are skipped
+static bool alarmRulesConfirm(alarmEventData_t event_data, bool* suppressed)
+{
+  *suppressed = false;
+  uint32_t mask = event_data.event->rules | event_data.event->zone->rules;
+  if (mask == 0) {
+    return !event_data.event->confirm || alarmConfirmationCheck();
+  };
+
+  int64_t now = esp_timer_get_time() / 1000;
+  bool hasPositive = false;
+  bool positive = false;
+  bool veto = false;
+  for (uint8_t i = 0; (i < _alarmRulesCount) && (mask != 0); i++, mask >>= 1) {
+    if (mask & 1) {
+      alarmRule_t* rule = &_alarmRules[i];
+      switch (rule->type) {
+        case ARL_K_OF_N:
+          hasPositive = true;
+          if (alarmRuleKofN(rule, event_data.sensor, now)) positive = true;
+          break;
+        case ARL_SEQUENCE:
+          if (event_data.event == rule->second) {
+            hasPositive = true;
+            if ((rule->last > 0) && ((now - rule->last) <= rule->window)) positive = true;
+          };
+          if (event_data.event == rule->first) {
+            rule->last = now;
+          };
+          break;
+        case ARL_UNLESS:
+          if ((event_data.event == rule->first) && (rule->last > 0) && ((now - rule->last) <= rule->window)) {
+            veto = true;
+          };
+          if (event_data.event == rule->second) {
+            rule->last = now;
+          };
+          break;
+      };
+    };
+  };
+
+  if (veto) {
+    rlog_i(logTAG, "Alarm for sensor [ %s ] suppressed by correlation rule", event_data.sensor->name);
+    *suppressed = true;
+    return true;
+  };
+  if (event_data.event->confirm) {
+    return hasPositive ? positive : alarmConfirmationCheck();
+  };
+  return true;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------
 // --------------------------------------------------- Initialization ----------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
@@ -760,20 +1479,41 @@ static void alarmOtaEventHandler(void* arg, esp_event_base_t event_base, int32_t
   };
 }
 
+static void alarmBypassRestore();
+
 static void alarmStartEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
   if (event_id == RE_SYS_STARTED) {
+    // Zone bypasses restored from parameters
+    alarmBypassRestore();
     rlog_v(logTAG, "Restore security mode...");
-    alarmModeChange(_alarmMode, ACC_STORED, nullptr, true, true);
+    alarmPartitionHandle_t partition;
+    STAILQ_FOREACH(partition, _alarmPartitions, next) {
+      alarmModeChange(partition, partition->mode, ACC_STORED, nullptr, true, true);
+    };
   };
 }
 
+static bool alarmBypassParamsInit(paramsGroupHandle_t group);
+static void alarmBypassParamsRegister(alarmZoneHandle_t zone);
+static bool alarmBypassParamsChanged(void* value);
+static bool alarmRollingParamsInit(paramsGroupHandle_t group);
+static void alarmRollingParamsRegister(alarmSensorHandle_t sensor);
+
 static void alarmParamsEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
-  if (*(uint32_t*)event_data == (uint32_t)&_alarmMode) {
-    rlog_v(logTAG, "Security mode changed via MQTT, event_id=%d", event_id);
-    if (event_id == RE_PARAMS_CHANGED)  {
-      alarmModeChange(_alarmMode, ACC_MQTT, nullptr, true, true);
+  if ((event_id == RE_PARAMS_CHANGED) && alarmBypassParamsChanged(*(void**)event_data)) {
+    return;
+  };
+
+  alarmPartitionHandle_t partition;
+  STAILQ_FOREACH(partition, _alarmPartitions, next) {
+    if (*(uint32_t*)event_data == (uint32_t)&partition->mode) {
+      rlog_v(logTAG, "Security mode of partition [ %s ] changed via MQTT, event_id=%d", partition->name, event_id);
+      if (event_id == RE_PARAMS_CHANGED)  {
+        alarmModeChange(partition, partition->mode, ACC_MQTT, nullptr, true, true);
+      };
+      break;
     };
   };
 }
@@ -791,27 +1531,48 @@ static void alarmTimeEventHandler(void* arg, esp_event_base_t event_base, int32_
 }
 #endif // CONFIG_SILENT_MODE_ENABLE
 
+static paramsGroupHandle_t _alarmParamsGroup = nullptr;
+
+// Registers the mode parameter: "security/mode" for the main partition and "security/<topic>/mode" for the rest
+static bool alarmParamsRegisterPartition(alarmPartitionHandle_t partition)
+{
+  paramsGroupHandle_t pgPartition = _alarmParamsGroup;
+  if (partition != &_alarmPartMain) {
+    pgPartition = paramsRegisterGroup(_alarmParamsGroup, partition->topic, partition->topic, partition->name);
+    RE_MEM_CHECK(pgPartition, return false);
+  };
+
+  #if CONFIG_ALARM_MQTT_DEVICE_MODE
+    partition->param_mode = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U8, nullptr, pgPartition, 
+      CONFIG_ALARM_PARAMS_MODE_KEY, CONFIG_ALARM_PARAMS_MODE_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &partition->mode);
+  #else
+    partition->param_mode = paramsRegisterValue(OPT_KIND_PARAMETER_LOCATION, OPT_TYPE_U8, nullptr, pgPartition, 
+      CONFIG_ALARM_PARAMS_MODE_KEY, CONFIG_ALARM_PARAMS_MODE_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &partition->mode);
+  #endif // CONFIG_ALARM_MQTT_DEVICE_MODE
+  RE_MEM_CHECK(partition->param_mode, return false);
+  partition->param_mode->notify = false;
+  paramsSetLimitsU8(partition->param_mode, (uint8_t)ASM_DISABLED, (uint8_t)ASM_MAX-1);
+  return true;
+}
+
 static bool alarmParamsRegister()
 {
   paramsGroupHandle_t pgSecurity = paramsRegisterGroup(nullptr, 
     CONFIG_ALARM_PARAMS_ROOT_KEY, CONFIG_ALARM_PARAMS_ROOT_TOPIC, CONFIG_ALARM_PARAMS_ROOT_FRIENDLY);
   RE_MEM_CHECK(pgSecurity, return false);
+  _alarmParamsGroup = pgSecurity;
   
-  #if CONFIG_ALARM_MQTT_DEVICE_MODE
-    _alarmParamMode = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U8, nullptr, pgSecurity, 
-      CONFIG_ALARM_PARAMS_MODE_KEY, CONFIG_ALARM_PARAMS_MODE_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_alarmMode);
-  #else
-    _alarmParamMode = paramsRegisterValue(OPT_KIND_PARAMETER_LOCATION, OPT_TYPE_U8, nullptr, pgSecurity, 
-      CONFIG_ALARM_PARAMS_MODE_KEY, CONFIG_ALARM_PARAMS_MODE_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_alarmMode);
-  #endif // CONFIG_ALARM_MQTT_DEVICE_MODE
-  RE_MEM_CHECK(_alarmParamMode, return false);
-  _alarmParamMode->notify = false;
-  paramsSetLimitsU8(_alarmParamMode, (uint8_t)ASM_DISABLED, (uint8_t)ASM_MAX-1);
+  // Partitions and zones added before initialization
+  alarmPartitionHandle_t partition;
+  STAILQ_FOREACH(partition, _alarmPartitions, next) {
+    if (!alarmParamsRegisterPartition(partition)) return false;
+  };
+  if (!alarmBypassParamsInit(pgSecurity)) return false;
+  if (!alarmRollingParamsInit(pgSecurity)) return false;
 
-  paramsSetLimitsU32(
-    paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U32, nullptr, pgSecurity, 
-      CONFIG_ALARM_PARAMS_SIREN_DUR_KEY, CONFIG_ALARM_PARAMS_SIREN_DUR_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_sirenDuration),
-    CONFIG_ALARM_PARAMS_MIN_DURATION, CONFIG_ALARM_PARAMS_MAX_DURATION);
+  _sirenDurationParam = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U32, nullptr, pgSecurity, 
+    CONFIG_ALARM_PARAMS_SIREN_DUR_KEY, CONFIG_ALARM_PARAMS_SIREN_DUR_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_sirenDuration);
+  paramsSetLimitsU32(_sirenDurationParam, CONFIG_ALARM_PARAMS_MIN_DURATION, CONFIG_ALARM_PARAMS_MAX_DURATION);
   paramsSetLimitsU32(
     paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U32, nullptr, pgSecurity, 
       CONFIG_ALARM_PARAMS_FLASHER_DUR_KEY, CONFIG_ALARM_PARAMS_FLASHER_DUR_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_flasherDuration),
@@ -835,6 +1596,11 @@ static bool alarmParamsRegister()
       CONFIG_ALARM_PARAMS_EXIT_TIME_KEY, CONFIG_ALARM_PARAMS_EXIT_TIME_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_alarmExitTime),
     0, 600);
 
+  paramsSetLimitsU8(
+    paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U8, nullptr, pgSecurity, 
+      CONFIG_ALARM_PARAMS_LOG_FRAMES_KEY, CONFIG_ALARM_PARAMS_LOG_FRAMES_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_alarmLogFrames),
+    ALOG_NONE, ALOG_ALL);
+
   paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U8, nullptr, pgSecurity, 
     CONFIG_ALARM_PARAMS_FIX_RX433_CODES_KEY, CONFIG_ALARM_PARAMS_FIX_RX433_CODES_FRIENDLY, CONFIG_ALARM_PARAMS_QOS, &_alarmStoreUnknownRx433Codes);
 
@@ -847,8 +1613,10 @@ extern bool alarmSystemInit(cb_alarm_change_mode_t cb_mode)
   _alarmOnChangeMode = cb_mode;
 
   gpio_install_isr_service(0);
+  alarmCommandsInit();
 
-  return alarmSirenTimerCreate() 
+  return alarmPartitionsInit()
+      && alarmSirenTimerCreate() 
       && alarmFlasherTimerCreate() 
       && alarmParamsRegister()
       #if CONFIG_SILENT_MODE_ENABLE
@@ -858,6 +1626,155 @@ extern bool alarmSystemInit(cb_alarm_change_mode_t cb_mode)
       && eventHandlerRegister(RE_SYSTEM_EVENTS, RE_SYS_OTA, &alarmOtaEventHandler, nullptr);
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Lookup index -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Zones and sensors are chained in hash tables by topic and by name when they are added. The hash of a string is 
+ * computed once and kept in the item as its identifier, so a lookup compares strings only when the identifiers match.
+ * Strings are compared case-insensitively, so the hash is taken over lower case characters
+ * */
+
+static alarmZoneHandle_t _alarmZoneTopics[CONFIG_ALARM_TOPIC_INDEX_SIZE] = { nullptr };
+static alarmZoneHandle_t _alarmZoneNames[CONFIG_ALARM_TOPIC_INDEX_SIZE] = { nullptr };
+static alarmSensorHandle_t _alarmSensorTopics[CONFIG_ALARM_TOPIC_INDEX_SIZE] = { nullptr };
+static alarmSensorHandle_t _alarmSensorNames[CONFIG_ALARM_TOPIC_INDEX_SIZE] = { nullptr };
+
+// FNV-1a
+static uint32_t alarmHashString(const char* str, size_t len)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= (uint8_t)tolower((unsigned char)str[i]);
+    hash *= 16777619u;
+  };
+  return hash;
+}
+
+static inline uint32_t alarmHashId(const char* str)
+{
+  return str ? alarmHashString(str, strlen(str)) : 0;
+}
+
+static inline bool alarmTopicEqual(const char* topic, const char* str, size_t len)
+{
+  return topic && (strlen(topic) == len) && (strncasecmp(topic, str, len) == 0);
+}
+
+// Items with the same key keep the order in which they were added, the first one is found
+static void alarmZoneTopicInsert(alarmZoneHandle_t zone)
+{
+  alarmZoneHandle_t* slot = &_alarmZoneTopics[zone->topic_id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (*slot) slot = &(*slot)->topic_next;
+  zone->topic_next = nullptr;
+  *slot = zone;
+}
+
+static void alarmZoneNameInsert(alarmZoneHandle_t zone)
+{
+  alarmZoneHandle_t* slot = &_alarmZoneNames[zone->name_id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (*slot) slot = &(*slot)->name_next;
+  zone->name_next = nullptr;
+  *slot = zone;
+}
+
+static void alarmSensorTopicInsert(alarmSensorHandle_t sensor)
+{
+  alarmSensorHandle_t* slot = &_alarmSensorTopics[sensor->topic_id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (*slot) slot = &(*slot)->topic_next;
+  sensor->topic_next = nullptr;
+  *slot = sensor;
+}
+
+static void alarmSensorNameInsert(alarmSensorHandle_t sensor)
+{
+  alarmSensorHandle_t* slot = &_alarmSensorNames[sensor->name_id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (*slot) slot = &(*slot)->name_next;
+  sensor->name_next = nullptr;
+  *slot = sensor;
+}
+
+static void alarmZoneNamesInsert(alarmZoneHandle_t zone)
+{
+  zone->topic_id = alarmHashId(zone->topic);
+  zone->name_id = alarmHashId(zone->name);
+  zone->topic_next = nullptr;
+  zone->name_next = nullptr;
+  if (zone->topic) alarmZoneTopicInsert(zone);
+  if (zone->name) alarmZoneNameInsert(zone);
+}
+
+static void alarmSensorNamesInsert(alarmSensorHandle_t sensor)
+{
+  sensor->topic_id = alarmHashId(sensor->topic);
+  sensor->name_id = alarmHashId(sensor->name);
+  sensor->topic_next = nullptr;
+  sensor->name_next = nullptr;
+  if (sensor->topic) alarmSensorTopicInsert(sensor);
+  if (sensor->name) alarmSensorNameInsert(sensor);
+}
+
+static void alarmZoneNamesClear()
+{
+  memset(_alarmZoneTopics, 0, sizeof(_alarmZoneTopics));
+  memset(_alarmZoneNames, 0, sizeof(_alarmZoneNames));
+}
+
+static void alarmSensorNamesClear()
+{
+  memset(_alarmSensorTopics, 0, sizeof(_alarmSensorTopics));
+  memset(_alarmSensorNames, 0, sizeof(_alarmSensorNames));
+}
+
+static alarmZoneHandle_t alarmZoneFindTopic(const char* topic, size_t len)
+{
+  uint32_t id = alarmHashString(topic, len);
+  alarmZoneHandle_t item = _alarmZoneTopics[id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (item && !((item->topic_id == id) && alarmTopicEqual(item->topic, topic, len))) item = item->topic_next;
+  return item;
+}
+
+static alarmZoneHandle_t alarmZoneFindName(const char* name, size_t len)
+{
+  uint32_t id = alarmHashString(name, len);
+  alarmZoneHandle_t item = _alarmZoneNames[id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (item && !((item->name_id == id) && alarmTopicEqual(item->name, name, len))) item = item->name_next;
+  return item;
+}
+
+static alarmSensorHandle_t alarmSensorFindTopic(const char* topic, size_t len)
+{
+  uint32_t id = alarmHashString(topic, len);
+  alarmSensorHandle_t item = _alarmSensorTopics[id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (item && !((item->topic_id == id) && alarmTopicEqual(item->topic, topic, len))) item = item->topic_next;
+  return item;
+}
+
+static alarmSensorHandle_t alarmSensorFindName(const char* name, size_t len)
+{
+  uint32_t id = alarmHashString(name, len);
+  alarmSensorHandle_t item = _alarmSensorNames[id % CONFIG_ALARM_TOPIC_INDEX_SIZE];
+  while (item && !((item->name_id == id) && alarmTopicEqual(item->name, name, len))) item = item->name_next;
+  return item;
+}
+
+alarmZoneHandle_t alarmZoneFind(const char* key)
+{
+  if (!key) return nullptr;
+  size_t len = strlen(key);
+  alarmZoneHandle_t item = alarmZoneFindTopic(key, len);
+  return item ? item : alarmZoneFindName(key, len);
+}
+
+alarmSensorHandle_t alarmSensorFind(const char* key)
+{
+  if (!key) return nullptr;
+  size_t len = strlen(key);
+  alarmSensorHandle_t item = alarmSensorFindTopic(key, len);
+  return item ? item : alarmSensorFindName(key, len);
+}
+
 // -----------------------------------------------------------------------------------------------------------------------
 // -------------------------------------------------------- Zones --------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
@@ -888,6 +1805,7 @@ void alarmZonesFree()
     free(alarmZones);
     alarmZones = nullptr;
   };
+  alarmZoneNamesClear();
 }
 
 alarmZoneHandle_t alarmZoneAdd(const char* name, const char* topic, cb_relay_control_t cb_relay_ctrl)
@@ -905,25 +1823,456 @@ alarmZoneHandle_t alarmZoneAdd(const char* name, const char* topic, cb_relay_con
     item->last_clr = 0;
     item->relay_ctrl = cb_relay_ctrl;
     item->relay_state = false;
+    item->exit_delay = ALARM_DELAY_DEFAULT;
+    item->entry_delay = 0;
+    item->delay_state = AZS_IDLE;
+    item->delay_end = 0;
+    item->entry_sensor = nullptr;
+    item->entry_event = nullptr;
+    item->entry_confirmed = false;
+    item->partition = &_alarmPartMain;
+    item->bypass = AZB_NONE;
+    item->bypass_until = 0;
+    item->param_bypass = nullptr;
+    item->bypass_expires = 0;
+    item->param_bypass_until = nullptr;
     for (size_t i = 0; i < ASM_MAX; i++) {
       item->resp_set[i] = ASRS_NONE;
       item->resp_clr[i] = ASRS_NONE;
+      item->plan_set[i][0] = ASA_END;
+      item->plan_clr[i][0] = ASA_END;
     };
     STAILQ_INSERT_TAIL(alarmZones, item, next);
+    alarmZoneNamesInsert(item);
+    alarmBypassParamsRegister(item);
     return item;
   };
   return nullptr;
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------ Partitions -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+alarmPartitionHandle_t alarmPartitionAdd(const char* name, const char* topic, alarm_siren_policy_t siren_policy)
+{
+  if (!topic || !alarmPartitionsInit()) {
+    return nullptr;
+  };
+  if (alarmPartitionFind(topic)) {
+    rlog_e(logTAG, "Partition [ %s ] already exists", topic);
+    return nullptr;
+  };
+  alarmPartitionHandle_t item = (alarmPartitionHandle_t)esp_calloc(1, sizeof(alarmPartition_t));
+  RE_MEM_CHECK(item, return nullptr);
+  item->name = name;
+  item->topic = topic;
+  item->mode = ASM_DISABLED;
+  item->count = 0;
+  item->siren_policy = siren_policy;
+  item->exits = 0;
+  item->param_mode = nullptr;
+  STAILQ_INSERT_TAIL(_alarmPartitions, item, next);
+  // If the parameters have already been registered, register the mode of the new partition right away
+  if (_alarmParamsGroup) {
+    alarmParamsRegisterPartition(item);
+  };
+  return item;
+}
+
+alarmPartitionHandle_t alarmPartitionFind(const char* topic)
+{
+  if (_alarmPartitions && topic) {
+    alarmPartitionHandle_t item;
+    STAILQ_FOREACH(item, _alarmPartitions, next) {
+      if (item->topic && (strcasecmp(item->topic, topic) == 0)) {
+        return item;
+      };
+    };
+  };
+  return nullptr;
+}
+
+alarm_mode_t alarmPartitionModeGet(alarmPartitionHandle_t partition)
+{
+  return partition ? partition->mode : _alarmPartMain.mode;
+}
+
+void alarmZonePartitionSet(alarmZoneHandle_t zone, alarmPartitionHandle_t partition)
+{
+  if (zone) {
+    zone->partition = partition ? partition : &_alarmPartMain;
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- Snapshot ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Readers get a consistent copy through a sequence lock: the counter is odd while the snapshot is being written, 
+ * the reader repeats the copy if the counter was odd or has changed. Writers are serialized by a spinlock, so readers 
+ * never wait for the alarm task and the alarm task never waits for readers
+ * */
+
+static alarmSnapshot_t _alarmSnapshot;
+static uint32_t _alarmSnapshotSeq = 0;
+static portMUX_TYPE _alarmSnapshotLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void alarmSnapshotUpdate()
+{
+  portENTER_CRITICAL(&_alarmSnapshotLock);
+  uint32_t seq = _alarmSnapshotSeq;
+  __atomic_store_n(&_alarmSnapshotSeq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  _alarmSnapshot.mode = _alarmPartMain.mode;
+  _alarmSnapshot.alarms = _alarmPartMain.count;
+  _alarmSnapshot.siren = _sirenActive;
+  _alarmSnapshot.flasher = _flasherActive;
+  _alarmSnapshot.last_alarm = _alarmPartMain.last_alarm;
+  _alarmSnapshot.last_event = _alarmPartMain.last_event;
+  uint8_t count = 0;
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      if (count >= CONFIG_ALARM_SNAPSHOT_MAX_ZONES) break;
+      alarmSnapshotZone_t* item = &_alarmSnapshot.zones[count++];
+      item->topic = zone->topic;
+      item->mode = zone->partition ? zone->partition->mode : _alarmPartMain.mode;
+      item->status = zone->status;
+      item->bypass = zone->bypass;
+      item->relay = zone->relay_state;
+      item->last_set = zone->last_set;
+      item->last_clr = zone->last_clr;
+    };
+  };
+  _alarmSnapshot.zones_count = count;
+
+  __atomic_store_n(&_alarmSnapshotSeq, seq + 2, __ATOMIC_RELEASE);
+  portEXIT_CRITICAL(&_alarmSnapshotLock);
+  alarmWebNotify();
+}
+
+void alarmSnapshotGet(alarmSnapshot_t* snapshot)
+{
+  if (!snapshot) return;
+  uint32_t seq;
+  do {
+    seq = __atomic_load_n(&_alarmSnapshotSeq, __ATOMIC_ACQUIRE);
+    if (seq & 1) continue;
+    memcpy(snapshot, &_alarmSnapshot, sizeof(alarmSnapshot_t));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) || (seq != __atomic_load_n(&_alarmSnapshotSeq, __ATOMIC_RELAXED)));
+  snapshot->seq = seq >> 1;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Event records ----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Subscribers receive a pointer to a record from a fixed pool instead of live sensor and event structures. 
+ * The publisher's reference is dropped by a trailing RE_ALARM_RECORD_RELEASE event: the event loop dispatches events in order, 
+ * so by that time all handlers of the signal have already returned. Records are posted from the alarm task 
+ * and from the esp_timer task, so the sequence number is atomic
+ * */
+
+static alarmEventRecord_t _alarmRecords[CONFIG_ALARM_EVENT_POOL_SIZE];
+static uint32_t _alarmRecordNext = 0;
+static uint32_t _alarmRecordSeq = 0;
+
+static alarmEventRecord_t* alarmEventRecordAlloc()
+{
+  for (uint32_t i = 0; i < CONFIG_ALARM_EVENT_POOL_SIZE; i++) {
+    // The search start is only a hint, slots are taken by compare-and-swap
+    uint32_t index = (__atomic_load_n(&_alarmRecordNext, __ATOMIC_RELAXED) + i) % CONFIG_ALARM_EVENT_POOL_SIZE;
+    uint32_t expected = 0;
+    if (__atomic_compare_exchange_n(&_alarmRecords[index].refs, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      __atomic_store_n(&_alarmRecordNext, index + 1, __ATOMIC_RELAXED);
+      return &_alarmRecords[index];
+    };
+  };
+  return nullptr;
+}
+
+void alarmEventRecordRetain(const alarmEventRecord_t* record)
+{
+  if (record) {
+    __atomic_add_fetch(&((alarmEventRecord_t*)record)->refs, 1, __ATOMIC_RELAXED);
+  };
+}
+
+void alarmEventRecordRelease(const alarmEventRecord_t* record)
+{
+  if (record) {
+    __atomic_sub_fetch(&((alarmEventRecord_t*)record)->refs, 1, __ATOMIC_RELEASE);
+  };
+}
+
+static void alarmEventRecordPost(int32_t event_id, bool state, alarmEventData_t event_data)
+{
+  alarmEventRecord_t* record = alarmEventRecordAlloc();
+  if (!record) {
+    rlog_e(logTAG, "Event record pool is exhausted, event of sensor [ %s ] is not published", event_data.sensor->name);
+    return;
+  };
+  record->version = ALARM_EVENT_RECORD_VERSION;
+  record->seq = __atomic_add_fetch(&_alarmRecordSeq, 1, __ATOMIC_RELAXED);
+  record->sensor_type = event_data.sensor->type;
+  record->sensor_address = event_data.sensor->address;
+  record->sensor_name = event_data.sensor->name;
+  record->sensor_topic = event_data.sensor->topic;
+  record->zone_name = event_data.event->zone->name;
+  record->zone_topic = event_data.event->zone->topic;
+  record->event_index = (uint8_t)(event_data.event - event_data.sensor->events);
+  record->event_type = event_data.event->type;
+  record->state = state;
+  record->events_count = event_data.event->events_count;
+  record->event_last = event_data.event->event_last;
+  record->zone_status = event_data.event->zone->status;
+  record->mode = event_data.event->zone->partition->mode;
+  record->timestamp = event_data.timestamp;
+
+  if (!eventLoopPost(RE_ALARM_EVENTS, event_id, &record, sizeof(alarmEventRecord_t*), portMAX_DELAY)) {
+    alarmEventRecordRelease(record);
+    return;
+  };
+  // The signal is already queued and its handlers may read the record, so it can't be released in place:
+  // if the release event can't be posted, the slot is lost rather than reused too early
+  for (uint8_t i = 0; i < CONFIG_ALARM_EVENT_RELEASE_ATTEMPTS; i++) {
+    if (eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RECORD_RELEASE, &record, sizeof(alarmEventRecord_t*), portMAX_DELAY)) {
+      return;
+    };
+    vTaskDelay(1);
+  };
+  rlog_e(logTAG, "Failed to post release of event record %d, the record is not returned to the pool", record->seq);
+}
+
+static void alarmEventRecordEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+  if ((event_id == RE_ALARM_RECORD_RELEASE) && event_data) {
+    alarmEventRecordRelease(*(alarmEventRecord_t**)event_data);
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- Effects -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * The alarm task only detects and changes states; publishing and notifications are passed to the effects task 
+ * through a single-producer single-consumer ring. Calls from other tasks, or when the ring is full, are executed in place
+ * */
+
+typedef enum {
+  AEF_MQTT_STATUS = 0,
+  AEF_MQTT_PARTITION,
+  AEF_MQTT_EVENT,
+  AEF_TELEGRAM
+} alarm_effect_type_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t mode;                   // AEF_TELEGRAM: partition mode at the moment of the event
+  bool siren;                     // AEF_TELEGRAM: siren state at the moment of the event
+  alarmPartitionHandle_t partition;
+  alarmEventData_t event_data;    // AEF_TELEGRAM: only names and messages, they do not change at runtime
+  alarmEventValues_t values;      // AEF_MQTT_EVENT, AEF_TELEGRAM: event state at the moment of the event
+  alarmStatusValues_t status;     // AEF_MQTT_STATUS, AEF_MQTT_PARTITION: partition state at the moment of the change
+} alarmEffect_t;
+
+static void alarmResponsesTelegramSend(alarmEventData_t event_data, const alarmEventValues_t* values, alarm_mode_t mode, bool siren);
+
+static void alarmEventValuesGet(alarmEventData_t event_data, bool publish_local, alarmEventValues_t* values)
+{
+  values->zone_topic = event_data.event->zone->topic;
+  values->sensor_topic = event_data.sensor->topic;
+  values->msg = event_data.event->msg_set;
+  values->type = event_data.event->type;
+  values->state = event_data.event->state;
+  values->publish_local = publish_local && event_data.sensor->local_publish;
+  values->events_count = event_data.event->events_count;
+  values->event_last = event_data.event->event_last;
+  values->timestamp = event_data.timestamp;
+}
+
+// Zones hold a single copy of their values: a publication that runs later sends the zones as of the latest posting
+static portMUX_TYPE _alarmStatusLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void alarmStatusValuesGet(alarmPartitionHandle_t partition, alarmStatusValues_t* values)
+{
+  values->partition = partition;
+  values->mode = partition->mode;
+  values->count = partition->count;
+  values->annunciator = (partition == &_alarmPartMain) || partition->annunciator;
+  values->siren = _sirenActive;
+  values->flasher = _flasherActive;
+  values->last_event = partition->last_event;
+  values->last_alarm = partition->last_alarm;
+  values->last_event_sensor = partition->last_event_data.sensor;
+  values->last_alarm_sensor = partition->last_alarm_data.sensor;
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    portENTER_CRITICAL(&_alarmStatusLock);
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      if (zone->partition == partition) {
+        zone->values.status = zone->status;
+        zone->values.bypass = zone->bypass;
+        zone->values.relay = zone->relay_state;
+        zone->values.last_set = zone->last_set;
+        zone->values.last_clr = zone->last_clr;
+      };
+    };
+    portEXIT_CRITICAL(&_alarmStatusLock);
+  };
+}
+
+static void alarmZoneValuesGet(alarmZoneHandle_t zone, alarmZoneValues_t* values)
+{
+  portENTER_CRITICAL(&_alarmStatusLock);
+  *values = zone->values;
+  portEXIT_CRITICAL(&_alarmStatusLock);
+}
+
+#if CONFIG_ALARM_EFFECTS_QUEUE_SIZE > 0
+
+static const char* alarmEffectsTaskName = "alarm_fx";
+static TaskHandle_t _alarmEffectsTask = nullptr;
+static alarmEffect_t _alarmEffects[CONFIG_ALARM_EFFECTS_QUEUE_SIZE];
+// The head is written only by the alarm task, the tail - only by the effects task
+static uint32_t _alarmEffectsHead = 0;
+static uint32_t _alarmEffectsTail = 0;
+
+static bool alarmEffectsPost(const alarmEffect_t* effect)
+{
+  if (!_alarmEffectsTask || (xTaskGetCurrentTaskHandle() != _alarmTask)) return false;
+  uint32_t head = _alarmEffectsHead;
+  if ((head - __atomic_load_n(&_alarmEffectsTail, __ATOMIC_ACQUIRE)) >= CONFIG_ALARM_EFFECTS_QUEUE_SIZE) {
+    ALARM_STATS_INC(effects_overflow);
+    return false;
+  };
+  _alarmEffects[head % CONFIG_ALARM_EFFECTS_QUEUE_SIZE] = *effect;
+  __atomic_store_n(&_alarmEffectsHead, head + 1, __ATOMIC_RELEASE);
+  xTaskNotifyGive(_alarmEffectsTask);
+  return true;
+}
+
+static void alarmEffectsExec(const alarmEffect_t* effect)
+{
+  switch (effect->type) {
+    case AEF_MQTT_STATUS:
+      alarmMqttPublishStatusValues(&effect->status);
+      break;
+    case AEF_MQTT_PARTITION:
+      alarmMqttPublishPartitionValues(&effect->status);
+      break;
+    case AEF_MQTT_EVENT:
+      alarmMqttPublishEvent(&effect->values);
+      alarmLatencyFix(ALS_MQTT, effect->values.timestamp);
+      break;
+    case AEF_TELEGRAM:
+      alarmResponsesTelegramSend(effect->event_data, &effect->values, (alarm_mode_t)effect->mode, effect->siren);
+      break;
+    default:
+      break;
+  };
+}
+
+static void alarmEffectsTaskExec(void *pvParameters)
+{
+  alarmEffect_t effect;
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t tail = _alarmEffectsTail;
+    while (tail != __atomic_load_n(&_alarmEffectsHead, __ATOMIC_ACQUIRE)) {
+      // The slot is released before execution so the alarm task is not blocked by a long publication
+      effect = _alarmEffects[tail % CONFIG_ALARM_EFFECTS_QUEUE_SIZE];
+      tail++;
+      __atomic_store_n(&_alarmEffectsTail, tail, __ATOMIC_RELEASE);
+      alarmEffectsExec(&effect);
+    };
+  };
+  vTaskDelete(nullptr);
+}
+
+static bool alarmEffectsTaskCreate()
+{
+  if (!_alarmEffectsTask) {
+    _alarmEffectsHead = 0;
+    _alarmEffectsTail = 0;
+    xTaskCreatePinnedToCore(alarmEffectsTaskExec, alarmEffectsTaskName, CONFIG_ALARM_EFFECTS_STACK_SIZE, nullptr, CONFIG_ALARM_EFFECTS_PRIORITY, &_alarmEffectsTask, CONFIG_ALARM_EFFECTS_CORE); 
+    if (!_alarmEffectsTask) {
+      rloga_e("Failed to create task [ %s ]!", alarmEffectsTaskName);
+      return false;
+    };
+    rloga_i("Task [ %s ] has been successfully started", alarmEffectsTaskName);
+  };
+  return true;
+}
+
+static void alarmEffectsTaskDelete()
+{
+  if (_alarmEffectsTask) {
+    vTaskDelete(_alarmEffectsTask);
+    _alarmEffectsTask = nullptr;
+    rloga_d("Task [ %s ] was deleted", alarmEffectsTaskName);
+  };
+}
+
+static void alarmEffectsTaskSuspend(bool suspend)
+{
+  if (_alarmEffectsTask) {
+    if (suspend) {
+      vTaskSuspend(_alarmEffectsTask);
+    } else {
+      vTaskResume(_alarmEffectsTask);
+    };
+  };
+}
+
+#else
+
+static inline bool alarmEffectsPost(const alarmEffect_t* effect) { return false; }
+static inline bool alarmEffectsTaskCreate() { return true; }
+static inline void alarmEffectsTaskDelete() {}
+static inline void alarmEffectsTaskSuspend(bool suspend) {}
+
+#endif // CONFIG_ALARM_EFFECTS_QUEUE_SIZE
+
 // -----------------------------------------------------------------------------------------------------------------------
 // ------------------------------------------------------ Responses ------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
+// Converts a bit mask of responses into an ordered list of actions: actuators first, network I/O last
+static void alarmResponsesCompile(uint16_t responses, uint8_t* plan)
+{
+  static const struct { uint16_t flag; alarm_action_t action; } order[] = {
+    { ASR_SIREN,        ASA_SIREN },
+    { ASR_FLASHER,      ASA_FLASHER },
+    { ASR_BUZZER,       ASA_BUZZER },
+    { ASR_RELAY_ON,     ASA_RELAY_ON },
+    { ASR_RELAY_OFF,    ASA_RELAY_OFF },
+    { ASR_RELAY_SWITCH, ASA_RELAY_SWITCH },
+    { ASR_MQTT_EVENT,   ASA_MQTT_EVENT },
+    { ASR_TELEGRAM,     ASA_TELEGRAM }
+  };
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+    if (responses & order[i].flag) {
+      plan[count++] = order[i].action;
+    };
+  };
+  plan[count] = ASA_END;
+}
+
 void alarmResponsesSet(alarmZoneHandle_t zone, alarm_mode_t mode, uint16_t resp_set, uint16_t resp_clr)
 {
-  if (zone) {
+  if (zone && (mode < ASM_MAX)) {
     zone->resp_set[mode] = resp_set;
     zone->resp_clr[mode] = resp_clr;
+    alarmResponsesCompile(resp_set, zone->plan_set[mode]);
+    alarmResponsesCompile(resp_clr, zone->plan_clr[mode]);
   }
 }
 
@@ -939,6 +2288,7 @@ static alarm_control_t alarmResponsesSource(alarmEventData_t event_data)
 }
 
 static void alarmResponsesProcess(bool state, alarmEventData_t event_data);
+static bool alarmZoneEntryDefer(alarmEventData_t event_data, bool confirmed);
 static void alarmResponsesClrTimerEnd(void* arg)
 {
   alarmEventHandle_t event = (alarmEventHandle_t)arg;
@@ -969,7 +2319,7 @@ static bool alarmResponsesClrTimerCreate(alarmEventData_t event_data)
     timer_args.callback = &alarmResponsesClrTimerEnd;
     timer_args.name = "timer_event";
     timer_args.arg = event_data.event;
-    err = esp_timer_create(&timer_args, &event_data.event->timer_clr);
+    err = alarmTimerCreate(&timer_args, &event_data.event->timer_clr);
     if (err != ESP_OK) {
       rlog_e(logTAG, "Failed to create event timer!");
       goto error;
@@ -987,6 +2337,7 @@ static bool alarmResponsesClrTimerCreate(alarmEventData_t event_data)
     event_data.event->timer_data = esp_malloc(sizeof(alarmEventData_t));
     RE_MEM_CHECK(event_data.event->timer_data, return false);
     memcpy(event_data.event->timer_data, &event_data, sizeof(alarmEventData_t));
+    ((alarmEventData_t*)event_data.event->timer_data)->timestamp = 0;
 
     err = esp_timer_start_once(event_data.event->timer_clr, 1000 * event_data.event->timeout_clr);
     if (err != ESP_OK) {
@@ -1010,325 +2361,1531 @@ static bool alarmResponsesClrTimerCreate(alarmEventData_t event_data)
     return false;
 }
 
-static void alarmResponsesProcess(bool state, alarmEventData_t event_data)
+static void alarmResponsesRelay(alarmEventData_t event_data, alarm_action_t action)
 {
-  uint16_t responses = 0;
-  bool alarmConfirmed = true;
-  if (state) {
-    rlog_w(logTAG, "Alarm signal for sensor: [ %s ], zone: [ %s ], type: [ %d ]", 
-      event_data.sensor->name, event_data.event->zone->name, event_data.event->type);
-
-    // Alarm confirmation if enabled
-    alarmConfirmed = !event_data.event->confirm || alarmConfirmationCheck();
-
-    // Fix event status
-    responses = event_data.event->zone->resp_set[_alarmMode];
-    event_data.event->event_last = time(nullptr);
-    event_data.event->events_count++;
-    event_data.event->state = true;
-
-    // Fix zone status
-    event_data.event->zone->last_set = event_data.event->event_last;
-    if (event_data.event->zone->status < UINT16_MAX) {
-      event_data.event->zone->status++;
+  alarmZoneHandle_t zone = event_data.event->zone;
+  if (action == ASA_RELAY_ON) {
+    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RELAY_ON, event_data.sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
+    if (zone->relay_ctrl) {
+      zone->relay_state = zone->relay_ctrl(true);
+    };
+  } else if (action == ASA_RELAY_OFF) {
+    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RELAY_OFF, event_data.sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
+    if (zone->relay_ctrl) {
+      zone->relay_state = zone->relay_ctrl(false);
     };
+  } else if (action == ASA_RELAY_SWITCH) {
+    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RELAY_TOGGLE, event_data.sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
+    if (zone->relay_ctrl) {
+      zone->relay_state = zone->relay_ctrl(!zone->relay_state);
+    };
+  };
+}
 
-    // Fix total status
-    if (!_alarmExitLock) {
-      _alarmLastEvent = event_data.event->event_last;
-      _alarmLastEventData = event_data;
-      if (responses & ASR_ALARM_INC) {
-        if (_alarmCount < UINT32_MAX) {
-          _alarmCount++;
-        };
-        _alarmLastAlarm = event_data.event->event_last;
-        _alarmLastAlarmData = event_data;
-      };
-      if ((responses & ASR_ALARM_DEC) && (_alarmCount > 0)) {
-        _alarmCount--;
-      };
+static void alarmResponsesTelegramSend(alarmEventData_t event_data, const alarmEventValues_t* values, alarm_mode_t mode, bool siren)
+{
+  #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_ALARM
+    const char* msg_header = values->state ? event_data.event->msg_set : event_data.event->msg_clr;
+    if (msg_header) {
+      alarmTimestamp_t msg_ts;
+      alarmFormatTimestamp(values->event_last, &msg_ts);
+      ALARM_STATS_START(tgStart);
+      tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_ALARM, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_ALARM, CONFIG_TELEGRAM_DEVICE,
+        CONFIG_NOTIFY_TELEGRAM_ALARM_TEMPLATE, 
+          msg_header, 
+          event_data.sensor->name, event_data.event->zone->name,
+          alarmModeText(mode), 
+          siren ? CONFIG_ALARM_SIREN_ENABLED : CONFIG_ALARM_SIREN_DISABLED,
+          msg_ts.ts_dts, values->events_count);
+      ALARM_STATS_STOP(telegram, tgStart);
+      alarmLatencyFix(ALS_TELEGRAM, values->timestamp);
     };
+  #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_ALARM
+}
 
-    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_SIGNAL_SET, &event_data, sizeof(alarmEventData_t), portMAX_DELAY);
+static void alarmResponsesTelegram(bool state, alarmEventData_t event_data)
+{
+  alarm_mode_t mode = event_data.event->zone->partition->mode;
+  alarmEffect_t effect = { AEF_TELEGRAM, (uint8_t)mode, _sirenActive, nullptr, event_data, {}, {} };
+  alarmEventValuesGet(event_data, false, &effect.values);
+  // Deferred responses are applied after the entry delay, the message follows the response, not the current state
+  effect.values.state = state;
+  if (!alarmEffectsPost(&effect)) {
+    alarmResponsesTelegramSend(event_data, &effect.values, mode, _sirenActive);
+  };
+}
 
-    if (event_data.event->timeout_clr > 0) {
-      alarmResponsesClrTimerCreate(event_data);
-    };
-  } else {
-    rlog_w(logTAG, "Clear signal for sensor: [ %s ], zone: [ %s ], type: [ %d ]", 
-      event_data.sensor->name, event_data.event->zone->name, event_data.event->type);
+// The next periodic publication is scheduled by the task that processes the event, not by the publisher.
+// Returns false if the event was published in place
+static bool alarmMqttEventPost(alarmEventData_t event_data, bool publish_local)
+{
+  alarmEffect_t effect = { AEF_MQTT_EVENT, 0, false, nullptr, { nullptr, nullptr, 0 }, {}, {} };
+  alarmEventValuesGet(event_data, publish_local, &effect.values);
+  if (event_data.event->mqtt_interval > 0) {
+    event_data.event->mqtt_next = time(nullptr) + event_data.event->mqtt_interval;
+  };
+  if (alarmEffectsPost(&effect)) return true;
+  alarmMqttPublishEvent(&effect.values);
+  alarmLatencyFix(ALS_MQTT, effect.values.timestamp);
+  return false;
+}
 
-    // Fix event status
-    responses = event_data.event->zone->resp_clr[_alarmMode];
-    event_data.event->state = false;
+// Plan of a suppressed alarm: nothing is executed
+static const uint8_t _alarmPlanEmpty[1] = { ASA_END };
 
-    // Fix zone status
-    if (event_data.event->zone->status > 0) {
-      event_data.event->zone->status--;
-    };
-    if (event_data.event->zone->status == 0) {
-      event_data.event->zone->last_clr = time(nullptr);
-    };
+static void alarmResponsesApply(bool state, alarmEventData_t event_data, bool alarmConfirmed)
+{
+  // Responses are selected by the mode before processing of control events
+  alarmZoneHandle_t zone = event_data.event->zone;
+  alarmPartitionHandle_t partition = zone->partition;
+  alarm_mode_t mode = partition->mode;
+  uint16_t responses = state ? zone->resp_set[mode] : zone->resp_clr[mode];
+  bool exitLock = zone->delay_state == AZS_EXIT;
+  bool suppressed = event_data.event->suppressed;
+  if (suppressed) {
+    // The alarm was not counted, so its clearing is not counted either
+    responses &= ~(ASR_ALARM_INC | ASR_ALARM_DEC);
+  };
 
-    // Fix total status
-    if (!_alarmExitLock) {
-      if (responses & ASR_ALARM_INC) {
-        if (_alarmCount < UINT32_MAX) {
-          _alarmCount++;
-        };
-        _alarmLastAlarm = event_data.event->event_last;
-        _alarmLastAlarmData = event_data;
-      };
-      if ((responses & ASR_ALARM_DEC) && (_alarmCount > 0)) {
-        _alarmCount--;
+  // Fix total status
+  if (!exitLock) {
+    if (state) {
+      partition->last_event = event_data.event->event_last;
+      partition->last_event_data = event_data;
+    };
+    if (responses & ASR_ALARM_INC) {
+      if (partition->count < UINT32_MAX) {
+        partition->count++;
       };
+      partition->last_alarm = event_data.event->event_last;
+      partition->last_alarm_data = event_data;
     };
-
-    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_SIGNAL_CLEAR, &event_data, sizeof(alarmEventData_t), portMAX_DELAY);
-
-    if (event_data.event->timer_clr) {
-      if (esp_timer_is_active(event_data.event->timer_clr)) {
-        esp_timer_stop(event_data.event->timer_clr);
-      };
-      esp_timer_delete(event_data.event->timer_clr);
-      event_data.event->timer_clr = nullptr;
+    if ((responses & ASR_ALARM_DEC) && (partition->count > 0)) {
+      partition->count--;
     };
   };
 
-  // Handling arming switch events (ignore confirmation)
+  alarmLatencyFix(ALS_DECISION, event_data.timestamp);
+
+  // Handling arming switch events (ignore confirmation), they control the partition of the zone
   if (state) {
     if (event_data.event->type == ASE_CTRL_OFF) {
       #if CONFIG_ALARM_TOGETHER_DISABLE_SIREN_AND_ALARM
-        // alarmAlarmCancel(alarmSourceText(alarmResponsesSource(event_data), event_data.sensor->name));
-        alarmModeChange(ASM_DISABLED, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
+        // alarmAlarmCancel(partition, alarmSourceText(alarmResponsesSource(event_data), event_data.sensor->name));
+        alarmModeChange(partition, ASM_DISABLED, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
       #else 
         // If the alarm is currently active, then first we just reset the alarm
-        if (!alarmAlarmCancel(alarmSourceText(alarmResponsesSource(event_data), event_data.sensor->name))) {
-          alarmModeChange(ASM_DISABLED, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
+        if (!alarmAlarmCancel(partition, alarmSourceText(alarmResponsesSource(event_data), event_data.sensor->name))) {
+          alarmModeChange(partition, ASM_DISABLED, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
         };
       #endif // CONFIG_ALARM_TOGETHER_DISABLE_SIREN_AND_ALARM
     } else if (event_data.event->type == ASE_CTRL_ON) {
-      alarmModeChange(ASM_ARMED, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
+      alarmModeChange(partition, ASM_ARMED, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
     } else if (event_data.event->type == ASE_CTRL_PERIMETER) {
-      alarmModeChange(ASM_PERIMETER, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
+      alarmModeChange(partition, ASM_PERIMETER, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
     } else if (event_data.event->type == ASE_CTRL_OUTBUILDINGS) {
-      alarmModeChange(ASM_OUTBUILDINGS, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
+      alarmModeChange(partition, ASM_OUTBUILDINGS, alarmResponsesSource(event_data), event_data.sensor->name, false, false);
     };
   };
 
-  // Posting event on MQTT
-  if (responses & ASR_MQTT_EVENT) {
-    alarmMqttPublishEvent(event_data, true);
+  // Executing the precompiled response plan: actuators first, then relays, and only after that network I/O
+  bool notify = !exitLock && alarmConfirmed;
+  const uint8_t* plan = suppressed ? _alarmPlanEmpty : (state ? zone->plan_set[mode] : zone->plan_clr[mode]);
+  for (; *plan != ASA_END; plan++) {
+    switch (*plan) {
+      case ASA_SIREN:
+        if (state && notify && (partition->siren_policy != ASP_SILENT)) {
+          alarmAnnunciatorAcquire(partition);
+          if (partition->siren_policy == ASP_SIREN) {
+            alarmSirenAlarmOn();
+          } else {
+            alarmFlasherAlarmOn();
+          };
+        };
+        break;
+      case ASA_FLASHER:
+        if (state && notify && (partition->siren_policy != ASP_SILENT)) {
+          alarmAnnunciatorAcquire(partition);
+          alarmFlasherAlarmOn();
+        };
+        break;
+      case ASA_BUZZER:
+        if (state && notify) alarmBuzzerAlarmOn();
+        break;
+      case ASA_RELAY_ON:
+      case ASA_RELAY_OFF:
+      case ASA_RELAY_SWITCH:
+        alarmResponsesRelay(event_data, (alarm_action_t)*plan);
+        break;
+      case ASA_MQTT_EVENT:
+        alarmMqttEventPost(event_data, true);
+        break;
+      case ASA_TELEGRAM:
+        if (notify) alarmResponsesTelegram(state, event_data);
+        break;
+      default:
+        break;
+    };
   };
-  
-  // Sound and visual notification
-  if (state && !_alarmExitLock && alarmConfirmed) {
-    if (responses & ASR_BUZZER) {
-      alarmBuzzerAlarmOn();
+
+  // Publish status on MQTT broker
+  alarmMqttPublishPartition(partition);
+}
+
+static void alarmResponsesExec(bool state, alarmEventData_t event_data)
+{
+  bool alarmConfirmed = true;
+  if (state) {
+    rlog_w(logTAG, "Alarm signal for sensor: [ %s ], zone: [ %s ], type: [ %d ]", 
+      event_data.sensor->name, event_data.event->zone->name, event_data.event->type);
+
+    // Alarm confirmation if enabled
+    alarmConfirmed = alarmRulesConfirm(event_data, &event_data.event->suppressed);
+
+    // Fix event status
+    event_data.event->event_last = time(nullptr);
+    event_data.event->events_count++;
+    event_data.event->state = true;
+
+    // Fix zone status
+    event_data.event->zone->last_set = event_data.event->event_last;
+    if (event_data.event->zone->status < UINT16_MAX) {
+      event_data.event->zone->status++;
+    };
+
+    alarmEventRecordPost(RE_ALARM_SIGNAL_SET, true, event_data);
+
+    if (event_data.event->timeout_clr > 0) {
+      alarmResponsesClrTimerCreate(event_data);
+    };
+
+    // Entry delay: responses are postponed until the delay expires or the system is disarmed
+    if (!event_data.event->suppressed && alarmZoneEntryDefer(event_data, alarmConfirmed)) {
+      alarmMqttPublishPartition(event_data.event->zone->partition);
+      return;
+    };
+  } else {
+    rlog_w(logTAG, "Clear signal for sensor: [ %s ], zone: [ %s ], type: [ %d ]", 
+      event_data.sensor->name, event_data.event->zone->name, event_data.event->type);
+
+    // Fix event status
+    event_data.event->state = false;
+
+    // Fix zone status
+    if (event_data.event->zone->status > 0) {
+      event_data.event->zone->status--;
+    };
+    if (event_data.event->zone->status == 0) {
+      event_data.event->zone->last_clr = time(nullptr);
     };
-    if (responses & ASR_SIREN) {
-      alarmSirenAlarmOn();
+
+    alarmEventRecordPost(RE_ALARM_SIGNAL_CLEAR, false, event_data);
+
+    if (event_data.event->timer_clr) {
+      if (esp_timer_is_active(event_data.event->timer_clr)) {
+        esp_timer_stop(event_data.event->timer_clr);
+      };
+      esp_timer_delete(event_data.event->timer_clr);
+      event_data.event->timer_clr = nullptr;
+    };
+  };
+
+  alarmResponsesApply(state, event_data, alarmConfirmed);
+
+  // The suppressed alarm ends with the clearing of its signal
+  if (!state) {
+    event_data.event->suppressed = false;
+  };
+}
+
+static void alarmResponsesProcess(bool state, alarmEventData_t event_data)
+{
+  // Bypassed events are skipped, except for clearing a signal that was set before the bypass
+  if ((event_data.event->bypass & AZB_IGNORED) && (state || !event_data.event->state)) {
+    rlog_d(logTAG, "Event of sensor [ %s ] in zone [ %s ] is bypassed", event_data.sensor->name, event_data.event->zone->name);
+    return;
+  };
+
+  ALARM_STATS_START(respStart);
+  _alarmLatencyOrigin = event_data.timestamp;
+  alarmResponsesExec(state, event_data);
+  _alarmLatencyOrigin = 0;
+  ALARM_STATS_STOP(responses, respStart);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- Delays --------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// Nearest deadline of all zones (esp_timer_get_time), 0 - there are no running delays
+static int64_t _alarmDelayNext = 0;
+
+void alarmZoneDelaysSet(alarmZoneHandle_t zone, uint16_t exit_delay, uint16_t entry_delay)
+{
+  if (zone) {
+    zone->exit_delay = exit_delay;
+    zone->entry_delay = entry_delay;
+  };
+}
+
+static void alarmZoneDelayStart(alarmZoneHandle_t zone, alarm_zone_delay_t state, uint16_t delay)
+{
+  zone->delay_state = state;
+  zone->delay_end = esp_timer_get_time() + (int64_t)delay * 1000000;
+  if ((_alarmDelayNext == 0) || (zone->delay_end < _alarmDelayNext)) {
+    _alarmDelayNext = zone->delay_end;
+  };
+}
+
+// Starts exit delays for all zones of the partition, returns the longest delay in seconds
+static uint16_t alarmZonesExitStart(alarmPartitionHandle_t partition)
+{
+  uint16_t ret = 0;
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      if (zone->partition == partition) {
+        uint16_t delay = zone->exit_delay == ALARM_DELAY_DEFAULT ? _alarmExitTime : zone->exit_delay;
+        if (delay > 0) {
+          alarmZoneDelayStart(zone, AZS_EXIT, delay);
+          partition->exits++;
+          if (delay > ret) ret = delay;
+        };
+      };
     };
-    if (responses & ASR_FLASHER) {
-      alarmFlasherAlarmOn();
+  };
+  return ret;
+}
+
+// Cancels delays of the partition zones. The nearest deadline is left as is: if it is no longer relevant, 
+// the task will simply recalculate it
+static void alarmZonesDelaysCancel(alarmPartitionHandle_t partition)
+{
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      if (zone->partition == partition) {
+        if (zone->delay_state == AZS_ENTRY) {
+          rlog_w(logTAG, "Entry delay for zone [ %s ] canceled", zone->name);
+        };
+        zone->delay_state = AZS_IDLE;
+        zone->entry_sensor = nullptr;
+        zone->entry_event = nullptr;
+      };
     };
   };
+  partition->exits = 0;
+}
 
-  // Relay control
-  if (responses & ASR_RELAY_ON) {
-    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RELAY_ON, event_data.sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
-    if (event_data.event->zone->relay_ctrl) {
-      event_data.event->zone->relay_state = event_data.event->zone->relay_ctrl(true);
+static bool alarmZoneEntryDefer(alarmEventData_t event_data, bool confirmed)
+{
+  alarmZoneHandle_t zone = event_data.event->zone;
+  // Only intrusion alarms are delayed; tamper, fire, panic and control events are always processed immediately
+  if ((zone->entry_delay == 0) 
+   || (zone->partition->mode == ASM_DISABLED) 
+   || (event_data.event->type != ASE_ALARM) 
+   || !(zone->resp_set[zone->partition->mode] & ASR_ALARM_INC)) {
+    return false;
+  };
+  // The countdown is already running, the first event will be processed at the end of it
+  if (zone->delay_state == AZS_ENTRY) {
+    return true;
+  };
+  if (zone->delay_state == AZS_IDLE) {
+    rlog_w(logTAG, "Entry delay for zone [ %s ] started: %d s", zone->name, zone->entry_delay);
+    zone->entry_sensor = event_data.sensor;
+    zone->entry_event = event_data.event;
+    zone->entry_confirmed = confirmed;
+    alarmZoneDelayStart(zone, AZS_ENTRY, zone->entry_delay);
+    alarmBuzzerAlarmOn();
+    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_ENTRY_DELAY, &zone, sizeof(alarmZoneHandle_t), portMAX_DELAY);
+    return true;
+  };
+  return false;
+}
+
+static void alarmZonesExitEnd(alarmPartitionHandle_t partition)
+{
+  rlog_i(logTAG, "Exit delay for partition [ %s ] is over", partition->name);
+  #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
+    if (partition == &_alarmPartMain) {
+      tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_MODE_CHANGE, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_MODE_CHANGE, 
+        CONFIG_TELEGRAM_DEVICE, CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_ACTIVATED);
+    } else {
+      tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_MODE_CHANGE, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_MODE_CHANGE, 
+        CONFIG_TELEGRAM_DEVICE, CONFIG_NOTIFY_TELEGRAM_ALARM_PARTITION_ACTIVATED, partition->name);
+    };
+  #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_MODE_CHANGE
+}
+
+// Processes expired delays in the context of the alarm task, returns the time until the next deadline in milliseconds
+static uint32_t alarmZonesDelaysProcess()
+{
+  if (_alarmDelayNext == 0) return UINT32_MAX;
+  int64_t now = esp_timer_get_time();
+  if (now < _alarmDelayNext) return (_alarmDelayNext - now) / 1000 + 1;
+
+  int64_t next = 0;
+  alarmZoneHandle_t zone;
+  STAILQ_FOREACH(zone, alarmZones, next) {
+    if (zone->delay_state != AZS_IDLE) {
+      if (now >= zone->delay_end) {
+        if (zone->delay_state == AZS_EXIT) {
+          zone->delay_state = AZS_IDLE;
+          // The last exit delay of the partition is over
+          if ((zone->partition->exits > 0) && (--zone->partition->exits == 0)) {
+            alarmZonesExitEnd(zone->partition);
+          };
+        } else {
+          zone->delay_state = AZS_IDLE;
+          if (zone->entry_sensor && zone->entry_event) {
+            rlog_w(logTAG, "Entry delay for zone [ %s ] expired", zone->name);
+            alarmEventData_t event_data = {zone->entry_sensor, zone->entry_event, 0};
+            zone->entry_sensor = nullptr;
+            zone->entry_event = nullptr;
+            alarmResponsesApply(true, event_data, zone->entry_confirmed);
+          };
+        };
+      } else {
+        if ((next == 0) || (zone->delay_end < next)) next = zone->delay_end;
+      };
+    };
+  };
+  _alarmDelayNext = next;
+
+  return next > 0 ? (next - now) / 1000 + 1 : UINT32_MAX;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Decoders ---------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+  source_type_t source;
+  cb_alarm_decoder_key_t key;
+  cb_alarm_decoder_command_t command;
+  uint32_t sensors;               // Number of sensors of this type
+} alarmDecoder_t;
+
+#define ALARM_DECODER_SOURCES (IDS_MQTT + 1)
+
+static bool alarmDecodeWiredKey(input_data_t* data, uint32_t* key)
+{
+  if (data->gpio.bus == ALARM_EOL_BUS) return false;
+  *key = (data->gpio.bus << 16) | (data->gpio.address << 8) | data->gpio.pin;
+  return true;
+}
+
+static bool alarmDecodeEolKey(input_data_t* data, uint32_t* key)
+{
+  if (data->gpio.bus != ALARM_EOL_BUS) return false;
+  *key = data->gpio.pin;
+  return true;
+}
+
+static bool alarmDecodeGpioCommand(input_data_t* data, uint32_t* command)
+{
+  *command = data->gpio.value;
+  return true;
+}
+
+static bool alarmDecodeRx433Key(input_data_t* data, uint32_t* key)
+{
+  *key = data->rx433.value;
+  return true;
+}
+
+static bool alarmDecode20A4CKey(input_data_t* data, uint32_t* key)
+{
+  *key = data->rx433.value >> 4;
+  return true;
+}
+
+static bool alarmDecode20A4CCommand(input_data_t* data, uint32_t* command)
+{
+  *command = data->rx433.value & 0x0f;
+  return true;
+}
+
+static bool alarmDecodeMqttKey(input_data_t* data, uint32_t* key)
+{
+  *key = data->ext.id;
+  return true;
+}
+
+static bool alarmDecodeMqttCommand(input_data_t* data, uint32_t* command)
+{
+  *command = data->ext.value;
+  return true;
+}
+
+static bool alarmRollingKey(input_data_t* data, uint32_t* key);
+static bool alarmRollingCommand(input_data_t* data, uint32_t* command);
+
+// Built-in decoders, in the order of alarm_sensor_type_t
+static alarmDecoder_t _alarmDecoders[CONFIG_ALARM_MAX_SENSOR_TYPES] = {
+  { IDS_GPIO,  alarmDecodeWiredKey, alarmDecodeGpioCommand, 0 },    // AST_WIRED
+  { IDS_RX433, alarmDecodeRx433Key, nullptr, 0 },                   // AST_RX433_GENERIC
+  { IDS_RX433, alarmDecode20A4CKey, alarmDecode20A4CCommand, 0 },   // AST_RX433_20A4C
+  { IDS_MQTT,  alarmDecodeMqttKey,  alarmDecodeMqttCommand, 0 },    // AST_MQTT
+  { IDS_GPIO,  alarmDecodeEolKey,   alarmDecodeGpioCommand, 0 },    // AST_WIRED_EOL
+  { IDS_RX433, alarmRollingKey,     alarmRollingCommand, 0 }        // AST_RX433_ROLLING
+};
+
+// Types with at least one sensor, for each source
+static uint32_t _alarmDecoderMask[ALARM_DECODER_SOURCES] = { 0 };
+static alarmSensorHandle_t _alarmSensorIndex[CONFIG_ALARM_SENSOR_INDEX_SIZE] = { nullptr };
+
+static void alarmDecoderMaskUpdate()
+{
+  memset(_alarmDecoderMask, 0, sizeof(_alarmDecoderMask));
+  for (uint8_t type = 0; type < CONFIG_ALARM_MAX_SENSOR_TYPES; type++) {
+    alarmDecoder_t* decoder = &_alarmDecoders[type];
+    if ((decoder->sensors > 0) && decoder->key && ((uint32_t)decoder->source < ALARM_DECODER_SOURCES)) {
+      _alarmDecoderMask[decoder->source] |= (1UL << type);
+    };
+  };
+}
+
+bool alarmDecoderRegister(alarm_sensor_type_t type, source_type_t source, cb_alarm_decoder_key_t key, cb_alarm_decoder_command_t command)
+{
+  if (((uint32_t)type >= CONFIG_ALARM_MAX_SENSOR_TYPES) || ((uint32_t)source >= ALARM_DECODER_SOURCES) || !key) {
+    rlog_e(logTAG, "Invalid decoder for sensor type %d", type);
+    return false;
+  };
+  _alarmDecoders[type].source = source;
+  _alarmDecoders[type].key = key;
+  _alarmDecoders[type].command = command;
+  alarmDecoderMaskUpdate();
+  return true;
+}
+
+static inline uint32_t alarmSensorIndexHash(alarm_sensor_type_t type, uint32_t key)
+{
+  return ((key ^ ((uint32_t)type << 24)) * 2654435761u) % CONFIG_ALARM_SENSOR_INDEX_SIZE;
+}
+
+// Sensors with the same key keep the order in which they were added
+static void alarmSensorIndexInsert(alarmSensorHandle_t sensor)
+{
+  alarmSensorHandle_t* slot = &_alarmSensorIndex[alarmSensorIndexHash(sensor->type, sensor->address)];
+  while (*slot) {
+    slot = &(*slot)->index_next;
+  };
+  sensor->index_next = nullptr;
+  *slot = sensor;
+  if ((uint32_t)sensor->type < CONFIG_ALARM_MAX_SENSOR_TYPES) {
+    if (_alarmDecoders[sensor->type].sensors++ == 0) {
+      alarmDecoderMaskUpdate();
+    };
+  };
+}
+
+static void alarmSensorIndexClear()
+{
+  memset(_alarmSensorIndex, 0, sizeof(_alarmSensorIndex));
+  for (uint8_t type = 0; type < CONFIG_ALARM_MAX_SENSOR_TYPES; type++) {
+    _alarmDecoders[type].sensors = 0;
+  };
+  alarmDecoderMaskUpdate();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Sensors ----------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+STAILQ_HEAD(alarmSensorHead_t, alarmSensor_t);
+typedef struct alarmSensorHead_t *alarmSensorHeadHandle_t;
+
+static alarmSensorHeadHandle_t alarmSensors = nullptr;
+
+bool alarmSensorsInit()
+{
+  if (!alarmSensors) {
+    alarmSensors = (alarmSensorHeadHandle_t)esp_calloc(1, sizeof(alarmSensorHead_t));
+    RE_MEM_CHECK(alarmSensors, return false);
+    STAILQ_INIT(alarmSensors);
+  };
+  return true;
+}
+
+static void alarmSupervisionUnschedule(alarmSensorHandle_t sensor);
+static void alarmEventStatsClear();
+
+void alarmSensorsFree()
+{
+  if (alarmSensors) {
+    alarmSensorHandle_t itemS, tmpS;
+    STAILQ_FOREACH_SAFE(itemS, alarmSensors, next, tmpS) {
+      alarmSupervisionUnschedule(itemS);
+      STAILQ_REMOVE(alarmSensors, itemS, alarmSensor_t, next);
+      free(itemS);
+    };
+    free(alarmSensors);
+    alarmSensors = nullptr;
+  };
+  alarmSensorIndexClear();
+  alarmSensorNamesClear();
+  alarmEventStatsClear();
+}
+
+alarmSensorHandle_t alarmSensorAdd(alarm_sensor_type_t type, const char* name, const char* topic, bool local_publish, uint32_t address)
+{
+  if (!alarmSensors) {
+    alarmSensorsInit();
+  };
+  if (alarmSensors) {
+    alarmSensorHandle_t item = (alarmSensorHandle_t)esp_calloc(1, sizeof(alarmSensor_t));
+    RE_MEM_CHECK(item, return nullptr);
+    item->name = name;
+    item->topic = topic;
+    item->local_publish = local_publish;
+    item->type = type;
+    item->address = address;
+    for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+      item->events[i].zone = nullptr;
+      item->events[i].type = ASE_EMPTY;
+      item->events[i].value_set = 0;
+      item->events[i].msg_set = nullptr;
+      item->events[i].value_clr = 0;
+      item->events[i].msg_clr = nullptr;
+      item->events[i].threshold = 0;
+      item->events[i].timeout_clr = 0;
+      item->events[i].events_count = 0;
+      item->events[i].event_last = 0;
+    };
+    STAILQ_INSERT_TAIL(alarmSensors, item, next);
+    alarmSensorIndexInsert(item);
+    alarmSensorNamesInsert(item);
+    if (type == AST_RX433_ROLLING) {
+      alarmRollingParamsRegister(item);
+    };
+    return item;
+  };
+  return nullptr;
+}
+
+static void alarmSensorsReset(alarmPartitionHandle_t partition)
+{
+  if (alarmSensors) {
+    alarmSensorHandle_t itemS;
+    STAILQ_FOREACH(itemS, alarmSensors, next) {
+      for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+        if ((itemS->events[i].type == ASE_ALARM) 
+         && (!partition || (itemS->events[i].zone && (itemS->events[i].zone->partition == partition)))) {
+          itemS->events[i].events_count = 0;
+        };
+      };
+    };
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Rolling code -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// The last decoded RX433 frame: the key is extracted before the command and the counter check
+typedef struct {
+  uint32_t serial;
+  uint16_t counter;
+  uint8_t command;
+} alarmRollingFrame_t;
+
+static alarmRollingFrame_t _alarmRollingFrame = { 0, 0, 0 };
+static cb_alarm_rolling_decode_t _alarmRollingDecoder = nullptr;
+static paramsGroupHandle_t _alarmRollingGroup = nullptr;
+
+// Default format: counter (16 bits), serial number (12 bits), command (4 bits)
+static bool alarmRollingDecodeDefault(uint32_t code, uint32_t* serial, uint16_t* counter, uint8_t* command)
+{
+  *counter = code >> 16;
+  *serial = (code >> 4) & 0x0fff;
+  *command = code & 0x0f;
+  return true;
+}
+
+void alarmRollingDecoderSet(cb_alarm_rolling_decode_t decoder)
+{
+  _alarmRollingDecoder = decoder;
+}
+
+void alarmRollingResync(alarmSensorHandle_t sensor)
+{
+  if (sensor && (sensor->type == AST_RX433_ROLLING)) {
+    sensor->rolling &= ~ALARM_ROLLING_SYNCED;
+    sensor->rolling_pending = false;
+    rlog_w(logTAG, "Remote [ %s ]: counter synchronization reset", sensor->name);
+  };
+}
+
+static bool alarmRollingKey(input_data_t* data, uint32_t* key)
+{
+  cb_alarm_rolling_decode_t decoder = _alarmRollingDecoder ? _alarmRollingDecoder : alarmRollingDecodeDefault;
+  if (decoder(data->rx433.value, &_alarmRollingFrame.serial, &_alarmRollingFrame.counter, &_alarmRollingFrame.command)) {
+    *key = _alarmRollingFrame.serial;
+    return true;
+  };
+  return false;
+}
+
+static bool alarmRollingCommand(input_data_t* data, uint32_t* command)
+{
+  *command = _alarmRollingFrame.command;
+  return true;
+}
+
+static_assert(CONFIG_ALARM_ROLLING_STORE_INTERVAL < CONFIG_ALARM_ROLLING_WINDOW, "The rolling counter must be stored within the window");
+
+// Each accepted code is kept in memory, the flash is written only every CONFIG_ALARM_ROLLING_STORE_INTERVAL codes 
+// and on synchronization (forced)
+static void alarmRollingStore(alarmSensorHandle_t sensor, uint16_t counter, bool forced)
+{
+  sensor->rolling = ALARM_ROLLING_SYNCED | counter;
+  sensor->rolling_pending = false;
+  if (sensor->param_rolling && (forced || ((uint16_t)(counter - sensor->rolling_stored) >= CONFIG_ALARM_ROLLING_STORE_INTERVAL))) {
+    sensor->rolling_stored = counter;
+    paramsValueStore((paramsEntryHandle_t)sensor->param_rolling, false);
+  };
+}
+
+// Raises the ASE_REPLAY event of the sensor instead of the command
+static void alarmRollingReject(alarmSensorHandle_t sensor, const char* reason, int64_t timestamp)
+{
+  ALARM_STATS_INC(frames_replayed);
+  rlog_e(logTAG, "Remote [ %s ]: %s, counter=%d, last=%d", sensor->name, reason, _alarmRollingFrame.counter, sensor->rolling & 0xFFFF);
+  eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_REPLAY, &sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
+  for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+    if ((sensor->events[i].type == ASE_REPLAY) && (sensor->events[i].zone)) {
+      if (!sensor->events[i].state) {
+        alarmEventData_t event_data = {sensor, &sensor->events[i], timestamp};
+        alarmResponsesProcess(true, event_data);
+      };
+      return;
+    };
+  };
+}
+
+/**
+ * Checks the counter of the current frame against the window of the sensor, returns true if the command can be executed.
+ * The first code of a new or reset remote becomes the reference point. A code behind the last accepted one is a replay; 
+ * a code too far ahead is accepted only if it is followed by the next one
+ * */
+static bool alarmRollingVerify(alarmSensorHandle_t sensor, int64_t timestamp)
+{
+  uint16_t counter = _alarmRollingFrame.counter;
+  uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+  uint16_t delta = counter - (uint16_t)(sensor->rolling & 0xFFFF);
+
+  if (sensor->rolling & ALARM_ROLLING_SYNCED) {
+    // Same code: continuation of the same press split into several packets
+    if (delta == 0) {
+      if ((now - sensor->rolling_time) <= CONFIG_ALARM_ROLLING_REPEAT) {
+        sensor->rolling_time = now;
+        return true;
+      };
+      alarmRollingReject(sensor, "code replay", timestamp);
+      return false;
+    };
+    if (delta <= CONFIG_ALARM_ROLLING_WINDOW) {
+      sensor->rolling_time = now;
+      alarmRollingStore(sensor, counter, false);
+      return true;
+    };
+    if (delta >= 0x8000) {
+      alarmRollingReject(sensor, "code replay", timestamp);
+      return false;
+    };
+  } else {
+    // Initial synchronization: there is nothing to compare the code with yet
+    rlog_w(logTAG, "Remote [ %s ]: counter synchronized at %d", sensor->name, counter);
+    sensor->rolling_time = now;
+    alarmRollingStore(sensor, counter, true);
+    return true;
+  };
+
+  // Resynchronization: two consecutive codes
+  if (sensor->rolling_pending && ((uint16_t)(counter - sensor->rolling_resync) == 1)) {
+    rlog_w(logTAG, "Remote [ %s ]: counter resynchronized at %d", sensor->name, counter);
+    sensor->rolling_time = now;
+    alarmRollingStore(sensor, counter, true);
+    return true;
+  };
+  // The code is ahead of the window: it is ignored until confirmed, this is not a replay
+  if (!sensor->rolling_pending || (sensor->rolling_resync != counter)) {
+    sensor->rolling_resync = counter;
+    sensor->rolling_pending = true;
+    rlog_w(logTAG, "Remote [ %s ]: counter out of window, counter=%d, last=%d", sensor->name, counter, sensor->rolling & 0xFFFF);
+  };
+  return false;
+}
+
+// Counters are stored in the parameters "security/rolling/<sensor>"
+static void alarmRollingParamsRegister(alarmSensorHandle_t sensor)
+{
+  if (_alarmRollingGroup && sensor->topic && !sensor->param_rolling) {
+    paramsEntryHandle_t param = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U32, nullptr, _alarmRollingGroup, 
+      sensor->topic, sensor->name, CONFIG_ALARM_PARAMS_QOS, &sensor->rolling);
+    if (param) {
+      param->notify = false;
+      sensor->param_rolling = param;
+    };
+  };
+}
+
+static bool alarmRollingParamsInit(paramsGroupHandle_t group)
+{
+  _alarmRollingGroup = paramsRegisterGroup(group, 
+    CONFIG_ALARM_PARAMS_ROLLING_KEY, CONFIG_ALARM_PARAMS_ROLLING_KEY, CONFIG_ALARM_PARAMS_ROLLING_FRIENDLY);
+  RE_MEM_CHECK(_alarmRollingGroup, return false);
+  if (alarmSensors) {
+    alarmSensorHandle_t sensor;
+    STAILQ_FOREACH(sensor, alarmSensors, next) {
+      if (sensor->type == AST_RX433_ROLLING) {
+        alarmRollingParamsRegister(sensor);
+      };
+    };
+  };
+  return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- Sensor events -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+void alarmEventSet(alarmSensorHandle_t sensor, alarmZoneHandle_t zone, uint8_t index, alarm_event_t type,  
+  uint32_t value_set, const char* message_set, uint32_t value_clear, const char* message_clr, 
+  uint16_t threshold, uint32_t timeout_clr, uint16_t mqtt_interval, bool alarm_confirm)
+{
+  if ((sensor) && (zone) && (index<CONFIG_ALARM_MAX_EVENTS)) {
+    sensor->events[index].zone = zone;
+    sensor->events[index].type = type;
+    sensor->events[index].state = false;
+    sensor->events[index].suppressed = false;
+    sensor->events[index].confirm = alarm_confirm;
+    sensor->events[index].value_set = value_set;
+    sensor->events[index].msg_set = message_set;
+    sensor->events[index].value_clr = value_clear;
+    sensor->events[index].msg_clr = message_clr;
+    sensor->events[index].threshold = threshold;
+    sensor->events[index].timeout_clr = timeout_clr;
+    sensor->events[index].events_count = 0;
+    sensor->events[index].event_last = 0;
+    sensor->events[index].mqtt_interval = mqtt_interval;
+    sensor->events[index].mqtt_next = 0;
+    sensor->events[index].timer_clr = nullptr;
+    sensor->events[index].bypass = (zone->bypass & (AZB_BYPASS | AZB_INHIBIT)) ? AZB_IGNORED : AZB_NONE;
+    sensor->events[index].bypass_until = 0;
+  };
+}
+
+alarmEventHandle_t alarmEventGet(alarmSensorHandle_t sensor, uint8_t index)
+{
+  if (sensor && (index < CONFIG_ALARM_MAX_EVENTS)) {
+    return &sensor->events[index];
+  };
+  return nullptr;
+}
+
+bool alarmEventCheckAddress(input_data_t* data, alarmSensorHandle_t sensor)
+{
+  if ((uint32_t)sensor->type >= CONFIG_ALARM_MAX_SENSOR_TYPES) return false;
+  alarmDecoder_t* decoder = &_alarmDecoders[sensor->type];
+  uint32_t key;
+  return decoder->key && (decoder->source == data->source) && decoder->key(data, &key) && (key == sensor->address);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- Bypass --------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// Nearest expiration time of bypasses, 0 - there are no bypasses with a limited duration
+static time_t _alarmBypassNext = 0;
+static paramsGroupHandle_t _alarmBypassGroup = nullptr;
+static paramsGroupHandle_t _alarmBypassUntilGroup = nullptr;
+
+static void alarmBypassNextFix(time_t until)
+{
+  if ((until > 0) && ((_alarmBypassNext == 0) || (until < _alarmBypassNext))) {
+    _alarmBypassNext = until;
+  };
+}
+
+// Recalculates the AZB_IGNORED flag of all events, so that the response path can check a single bit
+static void alarmBypassUpdate()
+{
+  if (alarmSensors) {
+    alarmSensorHandle_t sensor;
+    STAILQ_FOREACH(sensor, alarmSensors, next) {
+      for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+        alarmEventHandle_t event = &sensor->events[i];
+        uint8_t zone_bypass = event->zone ? event->zone->bypass : AZB_NONE;
+        if ((event->bypass | zone_bypass) & (AZB_BYPASS | AZB_INHIBIT)) {
+          event->bypass |= AZB_IGNORED;
+        } else {
+          event->bypass &= ~AZB_IGNORED;
+        };
+      };
+    };
+  };
+}
+
+// The expiry is stored along with the flags, so that a timed bypass does not become permanent after a restart
+static void alarmZoneBypassStore(alarmZoneHandle_t zone)
+{
+  zone->bypass_expires = (uint32_t)zone->bypass_until;
+  if (zone->param_bypass_until) {
+    paramsValueStore((paramsEntryHandle_t)zone->param_bypass_until, false);
+  };
+  if (zone->param_bypass) {
+    paramsValueStore((paramsEntryHandle_t)zone->param_bypass, false);
+  };
+}
+
+// Restores expiration times of zone bypasses from parameters, expired bypasses are removed by alarmBypassExpire()
+static void alarmBypassRestore()
+{
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      zone->bypass_until = zone->bypass ? (time_t)zone->bypass_expires : 0;
+      alarmBypassNextFix(zone->bypass_until);
+    };
+  };
+  alarmBypassUpdate();
+}
+
+void alarmZoneBypassSet(alarmZoneHandle_t zone, uint8_t bypass, uint32_t duration)
+{
+  if (zone) {
+    zone->bypass = bypass & (AZB_BYPASS | AZB_INHIBIT);
+    zone->bypass_until = (zone->bypass && (duration > 0)) ? time(nullptr) + duration : 0;
+    alarmBypassNextFix(zone->bypass_until);
+    alarmBypassUpdate();
+    alarmZoneBypassStore(zone);
+    rlog_w(logTAG, "Zone [ %s ] bypass set to %d for %d s", zone->name, zone->bypass, duration);
+  };
+}
+
+void alarmEventBypassSet(alarmEventHandle_t event, uint8_t bypass, uint32_t duration)
+{
+  if (event) {
+    event->bypass = (event->bypass & AZB_IGNORED) | (bypass & (AZB_BYPASS | AZB_INHIBIT));
+    event->bypass_until = ((bypass & (AZB_BYPASS | AZB_INHIBIT)) && (duration > 0)) ? time(nullptr) + duration : 0;
+    alarmBypassNextFix(event->bypass_until);
+    alarmBypassUpdate();
+  };
+}
+
+// Removes AZB_BYPASS when the partition is disarmed, nullptr - in all partitions
+static void alarmBypassDisarm(alarmPartitionHandle_t partition)
+{
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      if ((!partition || (zone->partition == partition)) && (zone->bypass & AZB_BYPASS)) {
+        zone->bypass &= ~AZB_BYPASS;
+        if (zone->bypass == AZB_NONE) {
+          zone->bypass_until = 0;
+        };
+        alarmZoneBypassStore(zone);
+      };
+    };
+  };
+  if (alarmSensors) {
+    alarmSensorHandle_t sensor;
+    STAILQ_FOREACH(sensor, alarmSensors, next) {
+      for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+        if (sensor->events[i].zone && (!partition || (sensor->events[i].zone->partition == partition))) {
+          sensor->events[i].bypass &= ~AZB_BYPASS;
+        };
+      };
+    };
+  };
+  alarmBypassUpdate();
+}
+
+// Removes expired bypasses, called from the periodic tasks
+static void alarmBypassExpire()
+{
+  if (_alarmBypassNext == 0) return;
+  time_t now = time(nullptr);
+  if (now < _alarmBypassNext) return;
+
+  _alarmBypassNext = 0;
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      if (zone->bypass_until > 0) {
+        if (now >= zone->bypass_until) {
+          rlog_w(logTAG, "Zone [ %s ] bypass expired", zone->name);
+          zone->bypass = AZB_NONE;
+          zone->bypass_until = 0;
+          alarmZoneBypassStore(zone);
+        } else {
+          alarmBypassNextFix(zone->bypass_until);
+        };
+      };
+    };
+  };
+  if (alarmSensors) {
+    alarmSensorHandle_t sensor;
+    STAILQ_FOREACH(sensor, alarmSensors, next) {
+      for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+        alarmEventHandle_t event = &sensor->events[i];
+        if (event->bypass_until > 0) {
+          if (now >= event->bypass_until) {
+            event->bypass &= AZB_IGNORED;
+            event->bypass_until = 0;
+          } else {
+            alarmBypassNextFix(event->bypass_until);
+          };
+        };
+      };
+    };
+  };
+  alarmBypassUpdate();
+  alarmMqttPublishPartitions();
+}
+
+// Zone flags are stored in the parameters "security/bypass/<zone>", expiration times in "security/bypass_until/<zone>"
+static void alarmBypassParamsRegister(alarmZoneHandle_t zone)
+{
+  if (_alarmBypassGroup && zone->topic && !zone->param_bypass) {
+    paramsEntryHandle_t param = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U8, nullptr, _alarmBypassGroup, 
+      zone->topic, zone->name, CONFIG_ALARM_PARAMS_QOS, &zone->bypass);
+    if (param) {
+      paramsSetLimitsU8(param, AZB_NONE, AZB_BYPASS | AZB_INHIBIT);
+      zone->param_bypass = param;
+    };
+  };
+  if (_alarmBypassUntilGroup && zone->topic && !zone->param_bypass_until) {
+    zone->param_bypass_until = paramsRegisterValue(OPT_KIND_PARAMETER, OPT_TYPE_U32, nullptr, _alarmBypassUntilGroup, 
+      zone->topic, zone->name, CONFIG_ALARM_PARAMS_QOS, &zone->bypass_expires);
+  };
+}
+
+static bool alarmBypassParamsInit(paramsGroupHandle_t group)
+{
+  _alarmBypassGroup = paramsRegisterGroup(group, 
+    CONFIG_ALARM_PARAMS_BYPASS_KEY, CONFIG_ALARM_PARAMS_BYPASS_KEY, CONFIG_ALARM_PARAMS_BYPASS_FRIENDLY);
+  RE_MEM_CHECK(_alarmBypassGroup, return false);
+  _alarmBypassUntilGroup = paramsRegisterGroup(group, 
+    CONFIG_ALARM_PARAMS_BYPASS_UNTIL_KEY, CONFIG_ALARM_PARAMS_BYPASS_UNTIL_KEY, CONFIG_ALARM_PARAMS_BYPASS_UNTIL_FRIENDLY);
+  RE_MEM_CHECK(_alarmBypassUntilGroup, return false);
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      alarmBypassParamsRegister(zone);
+    };
+  };
+  return true;
+}
+
+static bool alarmBypassParamsChanged(void* value)
+{
+  if (alarmZones) {
+    alarmZoneHandle_t zone;
+    STAILQ_FOREACH(zone, alarmZones, next) {
+      // The echo of a stored value must not change the expiration time: it is only removed along with the bypass
+      if (value == &zone->bypass) {
+        rlog_w(logTAG, "Zone [ %s ] bypass changed via MQTT: %d", zone->name, zone->bypass);
+        if (zone->bypass == AZB_NONE) {
+          zone->bypass_until = 0;
+        };
+        alarmBypassUpdate();
+        alarmMqttPublishPartition(zone->partition);
+        return true;
+      };
+      if (value == &zone->bypass_expires) {
+        zone->bypass_until = zone->bypass ? (time_t)zone->bypass_expires : 0;
+        alarmBypassNextFix(zone->bypass_until);
+        return true;
+      };
+    };
+  };
+  return false;
+}
+
+// Argument: "<zone> [seconds]" or "<sensor>:<event index> [seconds]"
+static bool alarmBypassCommand(uint8_t bypass, const char* arg)
+{
+  if (!arg) return false;
+  const char* end = arg;
+  while (*end && (*end != ' ')) end++;
+  uint32_t duration = *end ? strtoul(end, nullptr, 10) : 0;
+  const char* colon = (const char*)memchr(arg, ':', end - arg);
+
+  if (colon) {
+    alarmSensorHandle_t sensor = alarmSensorFindTopic(arg, colon - arg);
+    uint32_t index = strtoul(colon + 1, nullptr, 10);
+    if (sensor && (index < CONFIG_ALARM_MAX_EVENTS) && sensor->events[index].zone) {
+      alarmEventBypassSet(&sensor->events[index], bypass, duration);
+      alarmMqttPublishPartition(sensor->events[index].zone->partition);
+      return true;
+    };
+  } else {
+    alarmZoneHandle_t zone = alarmZoneFindTopic(arg, end - arg);
+    if (zone) {
+      alarmZoneBypassSet(zone, bypass, duration);
+      alarmMqttPublishPartition(zone->partition);
+      return true;
+    };
+  };
+  rlog_w(logTAG, "Bypass command: [ %s ] not found", arg);
+  return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Supervision ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Hashed timing wheel: a sensor is placed in the slot of its deadline, rounds count full wheel revolutions.
+ * Incoming frames only update the last-seen time; when the slot comes up, a sensor that was heard in the meantime 
+ * is simply moved forward to its new deadline.
+ * */
+LIST_HEAD(alarmWheelSlot_t, alarmSensor_t);
+static alarmWheelSlot_t _alarmWheel[CONFIG_ALARM_SUPERVISION_SLOTS];
+static uint32_t _alarmWheelTick = 0;
+static bool _alarmWheelStarted = false;
+// Sensors are (re)scheduled by alarmSensorSupervisionSet() in the caller's task while the alarm task walks the wheel
+static portMUX_TYPE _alarmWheelLock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t alarmSupervisionNow()
+{
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Must be called under _alarmWheelLock
+static void alarmSupervisionInsert(alarmSensorHandle_t sensor, uint32_t delay)
+{
+  if (!_alarmWheelStarted) {
+    _alarmWheelTick = alarmSupervisionNow() / CONFIG_ALARM_SUPERVISION_TICK;
+    _alarmWheelStarted = true;
+  };
+  uint32_t ticks = (delay + CONFIG_ALARM_SUPERVISION_TICK - 1) / CONFIG_ALARM_SUPERVISION_TICK;
+  if (ticks == 0) ticks = 1;
+  sensor->wheel_rounds = (ticks - 1) / CONFIG_ALARM_SUPERVISION_SLOTS;
+  sensor->wheel_active = true;
+  LIST_INSERT_HEAD(&_alarmWheel[(_alarmWheelTick + ticks) % CONFIG_ALARM_SUPERVISION_SLOTS], sensor, wheel);
+}
+
+// Must be called under _alarmWheelLock
+static void alarmSupervisionRemove(alarmSensorHandle_t sensor)
+{
+  if (sensor->wheel_active) {
+    LIST_REMOVE(sensor, wheel);
+    sensor->wheel_active = false;
+  };
+}
+
+static void alarmSupervisionUnschedule(alarmSensorHandle_t sensor)
+{
+  portENTER_CRITICAL(&_alarmWheelLock);
+  alarmSupervisionRemove(sensor);
+  portEXIT_CRITICAL(&_alarmWheelLock);
+}
+
+void alarmSensorSupervisionSet(alarmSensorHandle_t sensor, uint32_t interval)
+{
+  if (sensor) {
+    portENTER_CRITICAL(&_alarmWheelLock);
+    alarmSupervisionRemove(sensor);
+    sensor->supervision = interval;
+    sensor->seen = alarmSupervisionNow();
+    sensor->lost = false;
+    if (interval > 0) {
+      alarmSupervisionInsert(sensor, interval);
+    };
+    portEXIT_CRITICAL(&_alarmWheelLock);
+  };
+}
+
+// Sets or clears the ASE_LOST event of the sensor with the responses of its zone
+static void alarmSupervisionReport(alarmSensorHandle_t sensor, bool lost)
+{
+  for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+    if ((sensor->events[i].type == ASE_LOST) && (sensor->events[i].zone) && (sensor->events[i].state != lost)) {
+      if (lost) {
+        rlog_e(logTAG, "Sensor [ %s ] lost: no signals for %d s", sensor->name, sensor->supervision);
+      } else {
+        rlog_w(logTAG, "Sensor [ %s ] restored", sensor->name);
+      };
+      alarmEventData_t event_data = {sensor, &sensor->events[i], 0};
+      alarmResponsesProcess(lost, event_data);
+      return;
+    };
+  };
+}
+
+static void alarmSupervisionSeen(alarmSensorHandle_t sensor)
+{
+  bool restored = false;
+  portENTER_CRITICAL(&_alarmWheelLock);
+  sensor->seen = alarmSupervisionNow();
+  if (sensor->lost) {
+    sensor->lost = false;
+    alarmSupervisionInsert(sensor, sensor->supervision);
+    restored = true;
+  };
+  portEXIT_CRITICAL(&_alarmWheelLock);
+  if (restored) {
+    alarmSupervisionReport(sensor, false);
+  };
+}
+
+// Advances the wheel up to the current time, called from the periodic tasks
+static void alarmSupervisionProcess()
+{
+  bool lost = false;
+  uint32_t now = alarmSupervisionNow();
+  uint32_t tick = now / CONFIG_ALARM_SUPERVISION_TICK;
+  portENTER_CRITICAL(&_alarmWheelLock);
+  if (_alarmWheelStarted) {
+    while (_alarmWheelTick < tick) {
+      _alarmWheelTick++;
+      alarmSensorHandle_t sensor, tmp;
+      LIST_FOREACH_SAFE(sensor, &_alarmWheel[_alarmWheelTick % CONFIG_ALARM_SUPERVISION_SLOTS], wheel, tmp) {
+        if (sensor->wheel_rounds > 0) {
+          sensor->wheel_rounds--;
+        } else {
+          alarmSupervisionRemove(sensor);
+          uint32_t deadline = sensor->seen + sensor->supervision;
+          if (now >= deadline) {
+            // The sensor returns to the wheel with the next frame received from it
+            sensor->lost = true;
+            lost = true;
+          } else {
+            alarmSupervisionInsert(sensor, deadline - now);
+          };
+        };
+      };
+    };
+  };
+  portEXIT_CRITICAL(&_alarmWheelLock);
+
+  // Responses can't be executed in a critical section; reporting is idempotent, so all lost sensors are simply checked
+  if (lost && alarmSensors) {
+    alarmSensorHandle_t sensor;
+    STAILQ_FOREACH(sensor, alarmSensors, next) {
+      if (sensor->lost) {
+        alarmSupervisionReport(sensor, true);
+      };
+    };
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// -------------------------------------------------- Event statistics ---------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Every frame that sets an event updates two exponentially decayed counters (one hour and one day time constants) and 
+ * the hourly histogram. The number of repeats of an RF packet is known only when the packet ends, so the event matched 
+ * by the packet is remembered until then. Statistics are published one sensor per periodic call
+ * */
+
+#if CONFIG_ALARM_EVENT_STATS_ENABLE
+
+static alarmSensorHandle_t _alarmEventStatsRfSensor = nullptr;
+static uint8_t _alarmEventStatsRfIndex = 0;
+static alarmSensorHandle_t _alarmEventStatsCursor = nullptr;
+static time_t _alarmEventStatsNext = 0;
+
+static void alarmEventStatsClear()
+{
+  _alarmEventStatsRfSensor = nullptr;
+  _alarmEventStatsCursor = nullptr;
+}
+
+static void alarmEventStatsDecay(alarmEventStats_t* stats, uint32_t now)
+{
+  if (now > stats->rate_time) {
+    float dt = (float)(now - stats->rate_time);
+    stats->rate_hour *= expf(-dt / 3600.0f);
+    stats->rate_day *= expf(-dt / 86400.0f);
+  };
+  stats->rate_time = now;
+}
+
+static void alarmEventStatsCheck(alarmSensorHandle_t sensor, uint8_t index)
+{
+  alarmEventStats_t* stats = &sensor->events[index].stats;
+  uint8_t anomaly = AAN_NONE;
+  if ((CONFIG_ALARM_EVENT_STATS_DAY_LIMIT > 0) && (stats->rate_day >= CONFIG_ALARM_EVENT_STATS_DAY_LIMIT)) {
+    anomaly = AAN_RATE;
+  } else if ((stats->rate_hour >= CONFIG_ALARM_EVENT_STATS_BURST_MIN) 
+          // Until the daily rate has a day of history, it is about equal to the hourly one and can't serve as a baseline
+          && ((stats->rate_time - stats->rate_since) >= 86400)
+          && (stats->rate_hour > CONFIG_ALARM_EVENT_STATS_BURST_FACTOR * stats->rate_day / 24.0f)) {
+    anomaly = AAN_BURST;
+  } else if ((stats->repeat_count >= CONFIG_ALARM_EVENT_STATS_REPEAT_SAMPLES) 
+          && (stats->repeat_avg < CONFIG_ALARM_EVENT_STATS_REPEAT_LOW * 16)) {
+    anomaly = AAN_WEAK_SIGNAL;
+  };
+  if (anomaly != stats->anomaly) {
+    stats->anomaly = anomaly;
+    if (anomaly != AAN_NONE) {
+      rlog_w(logTAG, "Sensor [ %s ], event %d: anomaly %d", sensor->name, index, anomaly);
+      // Subscribers get the sensor identifier, not a pointer to the live structure
+      alarmAnomaly_t data = { sensor->type, sensor->address, index, sensor->events[index].type, (alarm_anomaly_t)anomaly };
+      eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_ANOMALY, &data, sizeof(alarmAnomaly_t), portMAX_DELAY);
+    };
+  };
+}
+
+// Called for every frame that sets the event
+static void alarmEventStatsFrame(alarmSensorHandle_t sensor, uint8_t index, input_data_t* data)
+{
+  alarmEventStats_t* stats = &sensor->events[index].stats;
+  uint32_t now = alarmSupervisionNow();
+  alarmEventStatsDecay(stats, now);
+  // The baseline starts over when less than one frame per day is left of the previous history (the counters never reach zero)
+  if (stats->rate_day < 1.0f) {
+    stats->rate_since = now;
+  };
+  stats->rate_hour += 1.0f;
+  stats->rate_day += 1.0f;
+  int hour = alarmTimestampHour(time(nullptr));
+  if ((hour >= 0) && (stats->hourly[hour] < UINT16_MAX)) {
+    stats->hourly[hour]++;
+  };
+  if (data->source == IDS_RX433) {
+    _alarmEventStatsRfSensor = sensor;
+    _alarmEventStatsRfIndex = index;
+  };
+  alarmEventStatsCheck(sensor, index);
+}
+
+// Called when an RF packet ends
+static void alarmEventStatsPacketEnd(uint16_t repeats)
+{
+  if (_alarmEventStatsRfSensor) {
+    alarmEventStats_t* stats = &_alarmEventStatsRfSensor->events[_alarmEventStatsRfIndex].stats;
+    uint8_t value = repeats > UINT8_MAX ? UINT8_MAX : (uint8_t)repeats;
+    if ((stats->repeat_min == 0) || (value < stats->repeat_min)) {
+      stats->repeat_min = value;
+    };
+    // Moving average with weight 1/8, in 1/16 of a repeat
+    if (stats->repeat_count == 0) {
+      stats->repeat_avg = value * 16;
+    } else {
+      stats->repeat_avg = (uint16_t)((int32_t)stats->repeat_avg + ((int32_t)value * 16 - (int32_t)stats->repeat_avg) / 8);
+    };
+    if (stats->repeat_count < UINT32_MAX) {
+      stats->repeat_count++;
+    };
+    alarmEventStatsCheck(_alarmEventStatsRfSensor, _alarmEventStatsRfIndex);
+    _alarmEventStatsRfSensor = nullptr;
+  };
+}
+
+static bool alarmEventStatsAppend(char* buf, size_t* len, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf + *len, CONFIG_ALARM_EVENT_STATS_BUF_SIZE - *len, format, args);
+  va_end(args);
+  if ((n < 0) || ((size_t)n >= CONFIG_ALARM_EVENT_STATS_BUF_SIZE - *len)) return false;
+  *len += n;
+  return true;
+}
+
+static void alarmEventStatsPublishSensor(alarmSensorHandle_t sensor)
+{
+  static char buf[CONFIG_ALARM_EVENT_STATS_BUF_SIZE];
+  size_t len = 0;
+  bool ok = alarmEventStatsAppend(buf, &len, "{");
+  bool first = true;
+  uint32_t now = alarmSupervisionNow();
+  for (uint8_t i = 0; ok && (i < CONFIG_ALARM_MAX_EVENTS); i++) {
+    alarmEventHandle_t event = &sensor->events[i];
+    if (event->type == ASE_EMPTY) continue;
+    // Decay to the current moment, so that anomalies are also cleared without new frames
+    alarmEventStatsDecay(&event->stats, now);
+    alarmEventStatsCheck(sensor, i);
+    ok = alarmEventStatsAppend(buf, &len, 
+      "%s\"%d\":{\"type\":%d,\"rate_hour\":%.2f,\"rate_day\":%.2f,\"repeat_min\":%d,\"repeat_avg\":%.2f,\"anomaly\":%d,\"hourly\":[",
+      first ? "" : ",", i, event->type, event->stats.rate_hour, event->stats.rate_day, 
+      event->stats.repeat_min, event->stats.repeat_avg / 16.0f, event->stats.anomaly);
+    for (uint8_t h = 0; ok && (h < 24); h++) {
+      ok = alarmEventStatsAppend(buf, &len, h ? ",%d" : "%d", event->stats.hourly[h]);
     };
+    ok = ok && alarmEventStatsAppend(buf, &len, "]}");
+    event->stats.repeat_min = 0;
+    first = false;
   };
-  if (responses & ASR_RELAY_OFF) {
-    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RELAY_OFF, event_data.sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
-    if (event_data.event->zone->relay_ctrl) {
-      event_data.event->zone->relay_state = event_data.event->zone->relay_ctrl(false);
-    };
+  ok = ok && alarmEventStatsAppend(buf, &len, "}");
+  if (!ok) {
+    rlog_e(logTAG, "Statistics buffer is too small for sensor [ %s ]", sensor->name);
+    return;
   };
-  if (responses & ASR_RELAY_SWITCH) {
-    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_RELAY_TOGGLE, event_data.sensor, sizeof(alarmSensorHandle_t), portMAX_DELAY);
-    if (event_data.event->zone->relay_ctrl) {
-      event_data.event->zone->relay_state = event_data.event->zone->relay_ctrl(!event_data.event->zone->relay_state);
+
+  if (sensor->topic && esp_heap_free_check() && statesMqttIsEnabled()) {
+    char* topic = mqttGetTopicSpecial3(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_STATS_LOCAL, 
+      CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_STATS_TOPIC, CONFIG_ALARM_MQTT_EVENT_STATS_TOPIC, sensor->topic);
+    if (topic) {
+      mqttPublish(topic, malloc_string(buf), CONFIG_ALARM_MQTT_STATS_QOS, CONFIG_ALARM_MQTT_STATS_RETAINED, true, true);
     };
   };
+}
 
-  // Sending notifications
-  if (!_alarmExitLock && alarmConfirmed && (responses & ASR_TELEGRAM)) {
-    #if CONFIG_TELEGRAM_ENABLE && CONFIG_NOTIFY_TELEGRAM_ALARM_ALARM
-      const char* msg_header = state ? event_data.event->msg_set : event_data.event->msg_clr;
-      if (msg_header) {
-        char msg_ts[CONFIG_FORMAT_STRFTIME_DTS_BUFFER_SIZE];
-        time2str_empty(CONFIG_FORMAT_DTS, &(event_data.event->event_last), msg_ts, sizeof(msg_ts));
-        tgSend(MK_SECURITY, CONFIG_ALARM_NOTIFY_PRIORITY_ALARM, CONFIG_NOTIFY_TELEGRAM_ALARM_ALERT_ALARM, CONFIG_TELEGRAM_DEVICE,
-          CONFIG_NOTIFY_TELEGRAM_ALARM_TEMPLATE, 
-            msg_header, 
-            event_data.sensor->name, event_data.event->zone->name,
-            alarmModeText(_alarmMode), 
-            _sirenActive ? CONFIG_ALARM_SIREN_ENABLED : CONFIG_ALARM_SIREN_DISABLED,
-            msg_ts, event_data.event->events_count);
-      };
-    #endif // CONFIG_NOTIFY_TELEGRAM_ALARM_ALARM
+// Called from the periodic tasks, one sensor per call keeps them short
+static void alarmEventStatsPublish()
+{
+  if ((CONFIG_ALARM_EVENT_STATS_INTERVAL == 0) || !alarmSensors) return;
+  if (!_alarmEventStatsCursor) {
+    if (time(nullptr) < _alarmEventStatsNext) return;
+    _alarmEventStatsNext = time(nullptr) + CONFIG_ALARM_EVENT_STATS_INTERVAL;
+    _alarmEventStatsCursor = STAILQ_FIRST(alarmSensors);
+    if (!_alarmEventStatsCursor) return;
   };
-
-  // Publish status on MQTT broker
-  alarmMqttPublishStatus();
+  alarmSensorHandle_t sensor = _alarmEventStatsCursor;
+  _alarmEventStatsCursor = STAILQ_NEXT(sensor, next);
+  alarmEventStatsPublishSensor(sensor);
 }
 
+#else
+
+static inline void alarmEventStatsClear() {}
+static inline void alarmEventStatsFrame(alarmSensorHandle_t sensor, uint8_t index, input_data_t* data) {}
+static inline void alarmEventStatsPacketEnd(uint16_t repeats) {}
+static inline void alarmEventStatsPublish() {}
+
+#endif // CONFIG_ALARM_EVENT_STATS_ENABLE
+
 // -----------------------------------------------------------------------------------------------------------------------
-// ---------------------------------------------------- Sensors ----------------------------------------------------------
+// ---------------------------------------------------- EOL sampler ------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-STAILQ_HEAD(alarmSensorHead_t, alarmSensor_t);
-typedef struct alarmSensorHead_t *alarmSensorHeadHandle_t;
+typedef struct {
+  alarmSensorHandle_t sensor;
+  alarmEolThresholds_t thresholds;
+  alarmEolFilter_t filter;
+} alarmEolInput_t;
 
-static alarmSensorHeadHandle_t alarmSensors = nullptr;
+static alarmEolInput_t _alarmEolInputs[CONFIG_ALARM_EOL_MAX_INPUTS];
+static uint8_t _alarmEolCount = 0;
+static TaskHandle_t _alarmEolTask = nullptr;
+static const char* alarmEolTaskName = "alarm_eol";
 
-bool alarmSensorsInit()
+static bool alarmEolTaskCreate();
+
+bool alarmSensorEolSet(alarmSensorHandle_t sensor, const alarmEolThresholds_t* thresholds)
 {
-  if (!alarmSensors) {
-    alarmSensors = (alarmSensorHeadHandle_t)esp_calloc(1, sizeof(alarmSensorHead_t));
-    RE_MEM_CHECK(alarmSensors, return false);
-    STAILQ_INIT(alarmSensors);
+  if (!sensor || !thresholds || (sensor->type != AST_WIRED_EOL) || (sensor->address >= ADC1_CHANNEL_MAX)) {
+    rlog_e(logTAG, "Invalid analog zone parameters");
+    return false;
   };
-  return true;
-}
 
-void alarmSensorsFree()
-{
-  if (alarmSensors) {
-    alarmSensorHandle_t itemS, tmpS;
-    STAILQ_FOREACH_SAFE(itemS, alarmSensors, next, tmpS) {
-      STAILQ_REMOVE(alarmSensors, itemS, alarmSensor_t, next);
-      free(itemS);
+  alarmEolInput_t* input = nullptr;
+  for (uint8_t i = 0; i < _alarmEolCount; i++) {
+    if (_alarmEolInputs[i].sensor == sensor) {
+      input = &_alarmEolInputs[i];
+      break;
     };
-    free(alarmSensors);
   };
-}
+  if (!input) {
+    if (_alarmEolCount >= CONFIG_ALARM_EOL_MAX_INPUTS) {
+      rlog_e(logTAG, "Too many analog zones");
+      return false;
+    };
+    input = &_alarmEolInputs[_alarmEolCount];
+  };
 
-alarmSensorHandle_t alarmSensorAdd(alarm_sensor_type_t type, const char* name, const char* topic, bool local_publish, uint32_t address)
-{
-  if (!alarmSensors) {
-    alarmSensorsInit();
+  ERR_CHECK(adc1_config_width(ADC_WIDTH_BIT_12), "Failed to set ADC width");
+  ERR_CHECK(adc1_config_channel_atten((adc1_channel_t)sensor->address, ADC_ATTEN_DB_11), "Failed to set ADC attenuation");
+  input->sensor = sensor;
+  input->thresholds = *thresholds;
+  alarmEolFilterInit(&input->filter);
+  // The sampler may already be running: the input becomes visible to it only when it is completely filled
+  if (input == &_alarmEolInputs[_alarmEolCount]) {
+    __atomic_store_n(&_alarmEolCount, _alarmEolCount + 1, __ATOMIC_RELEASE);
   };
-  if (alarmSensors) {
-    alarmSensorHandle_t item = (alarmSensorHandle_t)esp_calloc(1, sizeof(alarmSensor_t));
-    RE_MEM_CHECK(item, return nullptr);
-    item->name = name;
-    item->topic = topic;
-    item->local_publish = local_publish;
-    item->type = type;
-    item->address = address;
-    for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
-      item->events[i].zone = nullptr;
-      item->events[i].type = ASE_EMPTY;
-      item->events[i].value_set = 0;
-      item->events[i].msg_set = nullptr;
-      item->events[i].value_clr = 0;
-      item->events[i].msg_clr = nullptr;
-      item->events[i].threshold = 0;
-      item->events[i].timeout_clr = 0;
-      item->events[i].events_count = 0;
-      item->events[i].event_last = 0;
-    };
-    STAILQ_INSERT_TAIL(alarmSensors, item, next);
-    return item;
+
+  // Analog zones are usually configured after the alarm task has been started
+  if (_alarmTask) {
+    return alarmEolTaskCreate();
   };
-  return nullptr;
+  return true;
 }
 
-static void alarmSensorsReset()
+// Clears events first, then sets, so that the zone status does not jump
+static void alarmEolDispatch(alarmSensorHandle_t sensor, alarm_eol_state_t state, int64_t timestamp)
 {
-  if (alarmSensors) {
-    alarmSensorHandle_t itemS;
-    STAILQ_FOREACH(itemS, alarmSensors, next) {
-      for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
-        if (itemS->events[i].type == ASE_ALARM) {
-          itemS->events[i].events_count = 0;
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
+      alarmEventHandle_t event = &sensor->events[i];
+      if ((event->type != ASE_EMPTY) && (event->type != ASE_LOST) && (event->type != ASE_REPLAY)) {
+        bool active = (event->value_set & AEL_MASK(state)) != 0;
+        if ((active != event->state) && (active == (pass == 1))) {
+          alarmEventData_t event_data = {sensor, event, timestamp};
+          alarmResponsesProcess(active, event_data);
         };
       };
     };
   };
 }
 
-// -----------------------------------------------------------------------------------------------------------------------
-// ------------------------------------------------- Sensor events -------------------------------------------------------
-// -----------------------------------------------------------------------------------------------------------------------
-
-void alarmEventSet(alarmSensorHandle_t sensor, alarmZoneHandle_t zone, uint8_t index, alarm_event_t type,  
-  uint32_t value_set, const char* message_set, uint32_t value_clear, const char* message_clr, 
-  uint16_t threshold, uint32_t timeout_clr, uint16_t mqtt_interval, bool alarm_confirm)
+// Samples all channels in one pass, only changes of the line state are sent to the alarm task
+static void alarmEolTaskExec(void *pvParameters)
 {
-  if ((sensor) && (zone) && (index<CONFIG_ALARM_MAX_EVENTS)) {
-    sensor->events[index].zone = zone;
-    sensor->events[index].type = type;
-    sensor->events[index].state = false;
-    sensor->events[index].confirm = alarm_confirm;
-    sensor->events[index].value_set = value_set;
-    sensor->events[index].msg_set = message_set;
-    sensor->events[index].value_clr = value_clear;
-    sensor->events[index].msg_clr = message_clr;
-    sensor->events[index].threshold = threshold;
-    sensor->events[index].timeout_clr = timeout_clr;
-    sensor->events[index].events_count = 0;
-    sensor->events[index].event_last = 0;
-    sensor->events[index].mqtt_interval = mqtt_interval;
-    sensor->events[index].mqtt_next = 0;
-    sensor->events[index].timer_clr = nullptr;
+  TickType_t lastWake = xTaskGetTickCount();
+  while (1) {
+    uint8_t count = __atomic_load_n(&_alarmEolCount, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < count; i++) {
+      alarmEolInput_t* input = &_alarmEolInputs[i];
+      uint32_t sum = 0;
+      for (uint8_t n = 0; n < CONFIG_ALARM_EOL_OVERSAMPLE; n++) {
+        sum += adc1_get_raw((adc1_channel_t)input->sensor->address);
+      };
+      if (alarmEolFilterUpdate(&input->filter, &input->thresholds, sum / CONFIG_ALARM_EOL_OVERSAMPLE)) {
+        alarmInput_t queue_data;
+        memset(&queue_data, 0, sizeof(alarmInput_t));
+        queue_data.timestamp = esp_timer_get_time();
+        queue_data.data.source = IDS_GPIO;
+        queue_data.data.count = 1;
+        queue_data.data.gpio.bus = ALARM_EOL_BUS;
+        queue_data.data.gpio.pin = (uint8_t)input->sensor->address;
+        queue_data.data.gpio.value = (uint8_t)input->filter.state;
+        alarmQueuePost(&queue_data);
+      };
+    };
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONFIG_ALARM_EOL_PERIOD));
   };
+  vTaskDelete(nullptr);
 }
 
-bool alarmEventCheckAddress(input_data_t* data, alarmSensorHandle_t sensor)
+static bool alarmEolTaskCreate()
 {
-  switch (sensor->type) {
-    case AST_RX433_GENERIC:
-      return (data->source == IDS_RX433) && (data->rx433.value == sensor->address);
-    case AST_RX433_20A4C:
-      return (data->source == IDS_RX433) && ((data->rx433.value >> 4) == sensor->address);
-    case AST_WIRED:
-      return (data->source == IDS_GPIO) && (((data->gpio.bus << 16) | (data->gpio.address << 8) | data->gpio.pin) == sensor->address);
-    case AST_MQTT:
-      return (data->source == IDS_MQTT) && (data->ext.id == sensor->address);
-    default:
+  if ((_alarmEolCount > 0) && !_alarmEolTask) {
+    xTaskCreatePinnedToCore(alarmEolTaskExec, alarmEolTaskName, CONFIG_ALARM_EOL_STACK_SIZE, nullptr, CONFIG_TASK_PRIORITY_ALARM, &_alarmEolTask, CONFIG_TASK_CORE_ALARM); 
+    if (!_alarmEolTask) {
+      rloga_e("Failed to create task [ %s ]!", alarmEolTaskName);
       return false;
+    };
+    rloga_i("Task [ %s ] has been successfully started", alarmEolTaskName);
   };
-  return false;
+  return true;
 }
 
-static bool alarmEventCheckValueSet(input_data_t* data, alarm_sensor_type_t type, alarmEventHandle_t event)
+static void alarmEolTaskDelete()
 {
-  switch (type) {
-    case AST_RX433_GENERIC:
-      return true;
-    case AST_RX433_20A4C:
-      return (data->rx433.value & 0x0f) == event->value_set;
-    case AST_MQTT:
-      return data->ext.value == event->value_set;
-    default:
-      return data->gpio.value == event->value_set;
+  if (_alarmEolTask) {
+    vTaskDelete(_alarmEolTask);
+    _alarmEolTask = nullptr;
+    rloga_d("Task [ %s ] was deleted", alarmEolTaskName);
   };
-  return false;
 }
 
-static bool alarmEventCheckValueClr(input_data_t* data, alarm_sensor_type_t type, alarmEventHandle_t event)
-{
-  switch (type) {
-    case AST_RX433_GENERIC:
-      return false;
-    case AST_RX433_20A4C:
-      return (data->rx433.value & 0x0f) == event->value_clr;
-    case AST_MQTT:
-      return data->ext.value == event->value_clr;
-    default:
-      return data->gpio.value == event->value_clr;
-  };
-  return false;
-}
+// -----------------------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------- Input trace ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
 
-static bool alarmProcessIncomingData(input_data_t* data, bool end_of_packet)
+static uint32_t _alarmLogCounter = 0;
+
+static void alarmLogData(input_data_t* data, bool end_of_packet)
 {
-  // Log
   if (data->source == IDS_GPIO) {
     rlog_i(logTAG, "Incoming message:: end of packet: %d, source: GPIO, bus: %d, address: 0x%02X, pin: %d, full address: 0x%.8X, command: 0x%02X", 
       end_of_packet, data->gpio.bus, data->gpio.address, data->gpio.pin, ((data->gpio.bus << 16) | (data->gpio.address << 8) | data->gpio.pin), data->gpio.value);
@@ -1342,32 +3899,275 @@ static bool alarmProcessIncomingData(input_data_t* data, bool end_of_packet)
     rlog_e(logTAG, "Incoming message:: end of packet: %d, source: %d, UNSUPPORTED TYPE!!!", 
       end_of_packet, data->source);
   };
+}
+
+static void alarmLogIncomingData(input_data_t* data, bool end_of_packet, bool unmatched)
+{
+  #if CONFIG_ALARM_LOG_FRAMES > ALOG_NONE
+    if (unmatched) {
+      // All packets have already been logged on entry
+      if ((_alarmLogFrames == ALOG_UNMATCHED) || (_alarmLogFrames == ALOG_SAMPLED)) {
+        alarmLogData(data, end_of_packet);
+      };
+    } else {
+      if ((_alarmLogFrames == ALOG_ALL) 
+       || ((_alarmLogFrames == ALOG_SAMPLED) && ((++_alarmLogCounter % CONFIG_ALARM_LOG_FRAMES_SAMPLE) == 0))) {
+        alarmLogData(data, end_of_packet);
+      };
+    };
+  #endif // CONFIG_ALARM_LOG_FRAMES
+}
+
+#if CONFIG_ALARM_TRACE_SIZE > 0
+
+typedef struct {
+  int64_t timestamp;
+  input_data_t data;
+  bool end_of_packet;
+} alarmTraceItem_t;
+
+static alarmTraceItem_t _alarmTrace[CONFIG_ALARM_TRACE_SIZE];
+static uint32_t _alarmTraceHead = 0;
+static portMUX_TYPE _alarmTraceLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void alarmTraceIncomingData(input_data_t* data, bool end_of_packet)
+{
+  int64_t timestamp = esp_timer_get_time();
+  portENTER_CRITICAL(&_alarmTraceLock);
+  alarmTraceItem_t* item = &_alarmTrace[_alarmTraceHead % CONFIG_ALARM_TRACE_SIZE];
+  item->timestamp = timestamp;
+  item->end_of_packet = end_of_packet;
+  memcpy(&item->data, data, sizeof(input_data_t));
+  _alarmTraceHead++;
+  portEXIT_CRITICAL(&_alarmTraceLock);
+}
+
+// Called from the command handler: the ring is written by the alarm task, so it is copied under the lock first
+static void alarmTraceDump()
+{
+  alarmTraceItem_t* trace = (alarmTraceItem_t*)esp_calloc(1, sizeof(_alarmTrace));
+  RE_MEM_CHECK(trace, return);
+  portENTER_CRITICAL(&_alarmTraceLock);
+  uint32_t head = _alarmTraceHead;
+  memcpy(trace, _alarmTrace, sizeof(_alarmTrace));
+  portEXIT_CRITICAL(&_alarmTraceLock);
+
+  uint32_t count = head < CONFIG_ALARM_TRACE_SIZE ? head : CONFIG_ALARM_TRACE_SIZE;
+  rlog_i(logTAG, "Input trace: last %d of %d packets", count, head);
+  for (uint32_t i = head - count; i < head; i++) {
+    alarmTraceItem_t* item = &trace[i % CONFIG_ALARM_TRACE_SIZE];
+    rlog_i(logTAG, "Trace #%d at %lld us:", i, item->timestamp);
+    alarmLogData(&item->data, item->end_of_packet);
+  };
+  free(trace);
+}
+
+#else
+
+static inline void alarmTraceIncomingData(input_data_t* data, bool end_of_packet) {}
+static void alarmTraceDump() 
+{
+  rlog_w(logTAG, "Input trace is disabled");
+}
+
+#endif // CONFIG_ALARM_TRACE_SIZE
+
+// -----------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------- RF protection -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+// Token bucket: tokens are stored in thousandths to avoid floating point
+typedef struct {
+  uint32_t rate;
+  uint32_t burst;
+  uint32_t tokens;
+  int64_t  last;
+  uint32_t dropped;
+} alarmRateBucket_t;
+
+#define ALARM_RATE_SOURCES (IDS_MQTT + 1)
+
+static alarmRateBucket_t _alarmRateBuckets[ALARM_RATE_SOURCES] = {
+  { 0, 0, 0, 0, 0 },
+  { CONFIG_ALARM_RATE_LIMIT_GPIO, CONFIG_ALARM_RATE_BURST_GPIO, CONFIG_ALARM_RATE_BURST_GPIO * 1000, 0, 0 },
+  { CONFIG_ALARM_RATE_LIMIT_RX433, CONFIG_ALARM_RATE_BURST_RX433, CONFIG_ALARM_RATE_BURST_RX433 * 1000, 0, 0 },
+  { CONFIG_ALARM_RATE_LIMIT_MQTT, CONFIG_ALARM_RATE_BURST_MQTT, CONFIG_ALARM_RATE_BURST_MQTT * 1000, 0, 0 }
+};
+
+static bool alarmRateLimitCheck(source_type_t source)
+{
+  if ((uint32_t)source >= ALARM_RATE_SOURCES) return true;
+  alarmRateBucket_t* bucket = &_alarmRateBuckets[source];
+  if (bucket->rate == 0) return true;
+
+  // Refill the bucket in proportion to the elapsed time
+  int64_t now = esp_timer_get_time();
+  if (bucket->last > 0) {
+    uint64_t refill = (uint64_t)(now - bucket->last) * bucket->rate / 1000;
+    uint64_t tokens = bucket->tokens + refill;
+    bucket->tokens = tokens > (uint64_t)bucket->burst * 1000 ? bucket->burst * 1000 : (uint32_t)tokens;
+  };
+  bucket->last = now;
+
+  if (bucket->tokens >= 1000) {
+    bucket->tokens -= 1000;
+    return true;
+  };
+  bucket->dropped++;
+  return false;
+}
+
+static alarmSensor_t _alarmJamSensor;
+static bool _alarmJamActive = false;
+static uint32_t _alarmJamCount = 0;
+static int64_t _alarmJamWindow = 0;
+
+void alarmJammingSet(alarmZoneHandle_t zone, const char* message_set, const char* message_clr)
+{
+  _alarmJamSensor.type = AST_RX433_GENERIC;
+  _alarmJamSensor.name = CONFIG_ALARM_JAMMING_NAME;
+  _alarmJamSensor.topic = CONFIG_ALARM_JAMMING_TOPIC;
+  _alarmJamSensor.local_publish = false;
+  _alarmJamSensor.address = 0;
+  if (zone) {
+    alarmEventSet(&_alarmJamSensor, zone, 0, ASE_TAMPER, ALARM_VALUE_NONE, message_set, ALARM_VALUE_NONE, message_clr, 0, 0, 0, false);
+  };
+}
+
+static void alarmJammingChange(bool active)
+{
+  _alarmJamActive = active;
+  if (active) {
+    rlog_e(logTAG, "RX433 jamming detected: %d unidentified packets in %d ms", _alarmJamCount, CONFIG_ALARM_JAMMING_WINDOW);
+    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_JAMMING_ON, nullptr, 0, portMAX_DELAY);
+  } else {
+    rlog_w(logTAG, "RX433 jamming is over");
+    eventLoopPost(RE_ALARM_EVENTS, RE_ALARM_JAMMING_OFF, nullptr, 0, portMAX_DELAY);
+  };
+  if ((_alarmJamSensor.events[0].type != ASE_EMPTY) && (_alarmJamSensor.events[0].state != active)) {
+    alarmEventData_t event_data = {&_alarmJamSensor, &_alarmJamSensor.events[0], esp_timer_get_time()};
+    alarmResponsesProcess(active, event_data);
+  };
+}
+
+// Called for every RX433 packet (bad - packet was not identified or was dropped) and periodically with bad = false
+static void alarmJammingCheck(bool bad, bool periodic)
+{
+  int64_t now = esp_timer_get_time();
+  if ((now - _alarmJamWindow) >= (int64_t)CONFIG_ALARM_JAMMING_WINDOW * 1000) {
+    // The window is over: clear the state only after a quiet window
+    if (_alarmJamActive && (_alarmJamCount < CONFIG_ALARM_JAMMING_THRESHOLD_CLR)) {
+      alarmJammingChange(false);
+    };
+    _alarmJamWindow = now;
+    _alarmJamCount = 0;
+  };
+  if (!periodic) {
+    if (bad && (_alarmJamCount < UINT32_MAX)) {
+      _alarmJamCount++;
+    };
+    if (!_alarmJamActive && (_alarmJamCount >= CONFIG_ALARM_JAMMING_THRESHOLD_SET)) {
+      alarmJammingChange(true);
+    };
+  };
+}
+
+// An RX433 packet may be offered twice: at the threshold and at the end of the packet. Both calls pass the start time
+// of the packet, so it is counted and charged to the rate limiter only once
+static int64_t _alarmPacketTimestamp = -1;
+static bool _alarmPacketLimited = false;
+
+static bool alarmProcessDropped(input_data_t* data, bool first)
+{
+  if (first) {
+    ALARM_STATS_INC(frames_dropped);
+    if (data->source == IDS_RX433) {
+      alarmJammingCheck(true, false);
+    };
+  };
+  return false;
+}
+
+static bool alarmProcessIncomingData(input_data_t* data, int64_t timestamp, bool end_of_packet)
+{
+  bool first = (data->source != IDS_RX433) || (timestamp != _alarmPacketTimestamp);
+  bool limited = _alarmPacketLimited;
+  if (first) {
+    alarmStatsFrame(data->source);
+    alarmLatencyFix(ALS_DEQUEUE, timestamp);
+    limited = !alarmRateLimitCheck(data->source);
+    if (data->source == IDS_RX433) {
+      _alarmPacketTimestamp = timestamp;
+      _alarmPacketLimited = limited;
+    };
+  };
+
+  // Packets above the allowed rate are only matched (the index lookup is cheap): disarming is never dropped
+  if (!limited) {
+    // Trace and log (if enabled for all packets)
+    alarmTraceIncomingData(data, end_of_packet);
+    alarmLogIncomingData(data, end_of_packet, false);
+  };
 
-  // Scanning the entire list of sensors
-  alarmSensorHandle_t item, sensor = nullptr;
-  STAILQ_FOREACH(item, alarmSensors, next) {
-    // Check sensor type and address
-    if (alarmEventCheckAddress(data, item)) {
+  // Only the decoders of sensor types present for this source are called, the key leads directly to the index chain
+  alarmSensorHandle_t sensor = nullptr;
+  uint32_t types = ((uint32_t)data->source < ALARM_DECODER_SOURCES) ? _alarmDecoderMask[data->source] : 0;
+  while (types) {
+    alarm_sensor_type_t type = (alarm_sensor_type_t)__builtin_ctz(types);
+    types &= types - 1;
+    alarmDecoder_t* decoder = &_alarmDecoders[type];
+    uint32_t key, command = 0;
+    if (!decoder->key(data, &key)) continue;
+    bool has_command = decoder->command && decoder->command(data, &command);
+    
+    for (alarmSensorHandle_t item = _alarmSensorIndex[alarmSensorIndexHash(type, key)]; item; item = item->index_next) {
+      if ((item->type != type) || (item->address != key)) continue;
       sensor = item;
-      // Check values
+      // Any signal from the sensor confirms the connection
+      if (sensor->supervision > 0) {
+        alarmSupervisionSeen(sensor);
+      };
+      // Analog wired zones: each event follows its own mask of line states
+      if (sensor->type == AST_WIRED_EOL) {
+        if (limited) return alarmProcessDropped(data, first);
+        ALARM_STATS_INC(frames_matched);
+        alarmLatencyFix(ALS_MATCH, timestamp);
+        alarmEolDispatch(sensor, (alarm_eol_state_t)command, timestamp);
+        return true;
+      };
+      // Check values (ASE_LOST is raised only by the supervision, ASE_REPLAY - by the rolling code check)
+      // Without a command decoder, any signal of the sensor sets the event
       for (uint8_t i = 0; i < CONFIG_ALARM_MAX_EVENTS; i++) {
-        if (sensor->events[i].type != ASE_EMPTY) {
-          if (alarmEventCheckValueSet(data, sensor->type, &sensor->events[i])) {
+        if ((sensor->events[i].type != ASE_EMPTY) && (sensor->events[i].type != ASE_LOST) && (sensor->events[i].type != ASE_REPLAY)) {
+          if (decoder->command ? (has_command && (command == sensor->events[i].value_set)) : true) {
             if (data->count >= sensor->events[i].threshold) {
               // if (!sensor->events[i].state || (data->source != RTM_WIRED)) {
+              if (limited && (sensor->events[i].type != ASE_CTRL_OFF)) return alarmProcessDropped(data, first);
+              ALARM_STATS_INC(frames_matched);
+              alarmLatencyFix(ALS_MATCH, timestamp);
+              if ((sensor->type == AST_RX433_ROLLING) && !alarmRollingVerify(sensor, timestamp)) {
+                return true;
+              };
+              alarmEventStatsFrame(sensor, i, data);
               if (!sensor->events[i].state) {
-                alarmEventData_t event_data = {sensor, &sensor->events[i]};
+                alarmEventData_t event_data = {sensor, &sensor->events[i], timestamp};
                 alarmResponsesProcess(true, event_data);
               };
               return true;
             } else {
               return false;
             };
-          } else if (alarmEventCheckValueClr(data, sensor->type, &sensor->events[i])) {
+          } else if (has_command && (command == sensor->events[i].value_clr)) {
             if (data->count >= sensor->events[i].threshold) {
               // if (sensor->events[i].state || (data->source != RTM_WIRED)) {
+              if (limited) return alarmProcessDropped(data, first);
+              ALARM_STATS_INC(frames_matched);
+              alarmLatencyFix(ALS_MATCH, timestamp);
+              if ((sensor->type == AST_RX433_ROLLING) && !alarmRollingVerify(sensor, timestamp)) {
+                return true;
+              };
               if (sensor->events[i].state) {
-                alarmEventData_t event_data = {sensor, &sensor->events[i]};
+                alarmEventData_t event_data = {sensor, &sensor->events[i], timestamp};
                 alarmResponsesProcess(false, event_data);
               };
               return true;
@@ -1380,16 +4180,28 @@ static bool alarmProcessIncomingData(input_data_t* data, bool end_of_packet)
     };
   };
 
-  if (end_of_packet && (data->source == IDS_RX433) && (data->rx433.value > 0xffff)) {
+  if (limited) return alarmProcessDropped(data, first);
+
+  // Packets that could not be identified are always logged (if enabled)
+  if (first) {
+    ALARM_STATS_INC(frames_unmatched);
+  };
+  alarmLogIncomingData(data, end_of_packet, true);
+
+  // Packets that could not be identified are counted by the jamming detector
+  if (end_of_packet && (data->source == IDS_RX433)) {
+    alarmJammingCheck(true, false);
+  };
+
+  if (end_of_packet && !_alarmJamActive && (data->source == IDS_RX433) && (data->rx433.value > 0xffff)) {
     if (_alarmStoreUnknownRx433Codes && esp_heap_free_check() && statesMqttIsEnabled()) {
       char* sid = malloc_stringf("0x%.8X", data->rx433.value);
       if (sid) {
         char* topic = mqttGetTopicDevice2(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_RX433_UNKNOWN_LOCAL, CONFIG_ALARM_MQTT_RX433_UNKNOWN_TOPIC, sid);
         if (topic) {
-          time_t currtime = time(nullptr);
-          char timestamp[CONFIG_FORMAT_STRFTIME_DTS_BUFFER_SIZE];
-          time2str_empty(CONFIG_FORMAT_DTS, &currtime, timestamp, sizeof(timestamp));
-          mqttPublish(topic, timestamp, CONFIG_ALARM_MQTT_RX433_UNKNOWN_QOS, CONFIG_ALARM_MQTT_RX433_UNKNOWN_RETAINED, false, false);
+          alarmTimestamp_t timestamp;
+          alarmFormatTimestamp(time(nullptr), &timestamp);
+          mqttPublish(topic, timestamp.ts_dts, CONFIG_ALARM_MQTT_RX433_UNKNOWN_QOS, CONFIG_ALARM_MQTT_RX433_UNKNOWN_RETAINED, false, false);
           free(topic);
         };
         free(sid);
@@ -1415,6 +4227,123 @@ static bool alarmProcessIncomingData(input_data_t* data, bool end_of_packet)
   return false;
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------ Debounce -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+typedef struct {
+  alarmSensorHandle_t sensor;
+  uint16_t stable_ms;
+  uint16_t pulse_ms;
+  uint8_t value;                  // Confirmed level, 0xFF - not yet known
+  bool waiting;
+  gpio_data_t pending;            // Last unconfirmed level
+  int64_t timestamp;              // Receipt time of the first edge of the pending level
+  int64_t deadline;
+} alarmDebounce_t;
+
+static alarmDebounce_t _alarmDebounce[CONFIG_ALARM_DEBOUNCE_MAX_INPUTS];
+static uint8_t _alarmDebounceCount = 0;
+// Nearest deadline of all inputs (esp_timer_get_time), 0 - nothing to confirm
+static int64_t _alarmDebounceNext = 0;
+
+bool alarmSensorDebounceSet(alarmSensorHandle_t sensor, uint16_t stable_ms, uint16_t pulse_ms)
+{
+  if (!sensor || (sensor->type != AST_WIRED)) {
+    return false;
+  };
+  alarmDebounce_t* item = nullptr;
+  for (uint8_t i = 0; i < _alarmDebounceCount; i++) {
+    if (_alarmDebounce[i].sensor == sensor) {
+      item = &_alarmDebounce[i];
+      break;
+    };
+  };
+  if (!item) {
+    if (_alarmDebounceCount >= CONFIG_ALARM_DEBOUNCE_MAX_INPUTS) {
+      rlog_e(logTAG, "Too many inputs with debounce filter");
+      return false;
+    };
+    item = &_alarmDebounce[_alarmDebounceCount++];
+  };
+  item->sensor = sensor;
+  item->stable_ms = stable_ms;
+  item->pulse_ms = pulse_ms;
+  item->value = 0xFF;
+  item->waiting = false;
+  return true;
+}
+
+/**
+ * Returns true if the signal should be processed immediately. Otherwise, the level is held until it is confirmed:
+ * an edge back to the confirmed level discards the pending one, any new edge restarts the countdown
+ * */
+static bool alarmDebounceFilter(input_data_t* data, int64_t timestamp)
+{
+  if (_alarmDebounceCount == 0) return true;
+
+  uint32_t address = (data->gpio.bus << 16) | (data->gpio.address << 8) | data->gpio.pin;
+  alarmDebounce_t* item = nullptr;
+  for (uint8_t i = 0; i < _alarmDebounceCount; i++) {
+    if (_alarmDebounce[i].sensor->address == address) {
+      item = &_alarmDebounce[i];
+      break;
+    };
+  };
+  if (!item || (item->stable_ms == 0)) return true;
+
+  if (data->gpio.value == item->value) {
+    if (item->waiting) {
+      item->waiting = false;
+      ALARM_STATS_INC(frames_filtered);
+    };
+    return false;
+  };
+
+  if (item->waiting) {
+    ALARM_STATS_INC(frames_filtered);
+  } else {
+    item->timestamp = timestamp;
+  };
+  uint16_t hold = ((item->pulse_ms > 0) && (data->gpio.value == item->sensor->events[0].value_set)) ? item->pulse_ms : item->stable_ms;
+  item->pending = data->gpio;
+  item->waiting = true;
+  item->deadline = esp_timer_get_time() + (int64_t)hold * 1000;
+  if ((_alarmDebounceNext == 0) || (item->deadline < _alarmDebounceNext)) {
+    _alarmDebounceNext = item->deadline;
+  };
+  return false;
+}
+
+// Passes confirmed levels for processing, returns the time until the next deadline in milliseconds
+static uint32_t alarmDebounceProcess()
+{
+  if (_alarmDebounceNext == 0) return UINT32_MAX;
+  int64_t now = esp_timer_get_time();
+  if (now < _alarmDebounceNext) return (_alarmDebounceNext - now) / 1000 + 1;
+
+  int64_t next = 0;
+  for (uint8_t i = 0; i < _alarmDebounceCount; i++) {
+    alarmDebounce_t* item = &_alarmDebounce[i];
+    if (item->waiting) {
+      if (now >= item->deadline) {
+        item->waiting = false;
+        item->value = item->pending.value;
+        input_data_t data;
+        memset(&data, 0, sizeof(input_data_t));
+        data.source = IDS_GPIO;
+        data.count = 1;
+        data.gpio = item->pending;
+        alarmProcessIncomingData(&data, item->timestamp, true);
+      } else if ((next == 0) || (item->deadline < next)) {
+        next = item->deadline;
+      };
+    };
+  };
+  _alarmDebounceNext = next;
+  return next > 0 ? (next - now) / 1000 + 1 : UINT32_MAX;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------
 // ------------------------------------------------------ MQTT -----------------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
@@ -1436,90 +4365,149 @@ static const char* alarmMqttEventTopic(alarm_event_t type)
       return CONFIG_ALARM_MQTT_EVENTS_ASE_CONTROL_PERIMETER;
     case ASE_CTRL_OUTBUILDINGS:
       return CONFIG_ALARM_MQTT_EVENTS_ASE_CONTROL_OUTBUILDINGS;
+    case ASE_LOST:
+      return CONFIG_ALARM_MQTT_EVENTS_ASE_LOST;
+    case ASE_REPLAY:
+      return CONFIG_ALARM_MQTT_EVENTS_ASE_REPLAY;
     default:
       return CONFIG_ALARM_MQTT_EVENTS_ASE_ALARM;
   };
 }
 
-static char _alarmTimestampU[CONFIG_BUFFER_LEN_INT64_RADIX10];
-static char _alarmTimestampL[CONFIG_ALARM_TIMESTAMP_LONG_BUF_SIZE];
-static char _alarmTimestampS[CONFIG_ALARM_TIMESTAMP_SHORT_BUF_SIZE];
+#if CONFIG_ALARM_MQTT_BINARY
 
-static void alarmFormatTimestamps(time_t value)
+// Publishes a packed message to the "bin" subtopic next to the text one
+static void alarmMqttPublishPacked(const char* topic, alarmPack_t* pack, int qos, bool retained)
 {
-  static struct tm timeinfo;
+  char* payload = alarmPackBase64(pack);
+  RE_MEM_CHECK(payload, return);
+  char* topicBin = mqttGetSubTopic(topic, CONFIG_ALARM_MQTT_BINARY_TOPIC);
+  if (topicBin) {
+    mqttPublish(topicBin, payload, qos, retained, true, true);
+  } else {
+    free(payload);
+  };
+}
 
-  memset(_alarmTimestampU, 0, sizeof(_alarmTimestampU));
-  memset(_alarmTimestampL, 0, sizeof(_alarmTimestampL));
-  memset(_alarmTimestampS, 0, sizeof(_alarmTimestampS));
+static void alarmMqttPackEvent(const char* topic, const alarmEventValues_t* values)
+{
+  uint8_t buf[ALARM_PACK_EVENT_SIZE];
+  alarmPack_t pack;
+  alarmPackInit(&pack, buf, sizeof(buf), APK_EVENT);
+  alarmPackU8(&pack, values->type);
+  alarmPackU8(&pack, values->state);
+  alarmPackU32(&pack, values->events_count);
+  alarmPackU32(&pack, (uint32_t)values->event_last);
+  alarmMqttPublishPacked(topic, &pack, CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED);
+}
 
-  localtime_r(&value, &timeinfo);
-  _ui64toa(value, _alarmTimestampU, 10);
-  
-  if (value > 0) {
-    strftime(_alarmTimestampL, sizeof(_alarmTimestampL), CONFIG_ALARM_TIMESTAMP_LONG, &timeinfo);
-    strftime(_alarmTimestampS, sizeof(_alarmTimestampS), CONFIG_ALARM_TIMESTAMP_SHORT, &timeinfo);
-  } else {
-    strcpy(_alarmTimestampL, CONFIG_FORMAT_EMPTY_DATETIME);
-    strcpy(_alarmTimestampS, CONFIG_FORMAT_EMPTY_DATETIME);
+// Zones are packed in registration order, the same order is used for JSON
+static void alarmMqttPackStatus(const char* topic, const alarmStatusValues_t* values)
+{
+  alarmPartitionHandle_t partition = values->partition;
+  alarmZoneHandle_t zone;
+  alarmZoneValues_t zoneValues;
+  uint8_t zones = 0;
+  STAILQ_FOREACH(zone, alarmZones, next) {
+    if ((zone->partition == partition) && (zones < UINT8_MAX)) zones++;
+  };
+
+  size_t size = ALARM_PACK_STATUS_HEADER_SIZE + ALARM_PACK_STATUS_ZONE_SIZE * zones;
+  uint8_t* buf = (uint8_t*)malloc(size);
+  RE_MEM_CHECK(buf, return);
+
+  alarmPack_t pack;
+  alarmPackInit(&pack, buf, size, APK_STATUS);
+  alarmPackU8(&pack, values->mode);
+  alarmPackU8(&pack, values->annunciator ? (values->flasher << 1 | values->siren) : 0);
+  alarmPackU16(&pack, values->count);
+  alarmPackU32(&pack, (uint32_t)values->last_event);
+  alarmPackU32(&pack, values->last_event_sensor ? values->last_event_sensor->address : 0);
+  alarmPackU32(&pack, (uint32_t)values->last_alarm);
+  alarmPackU32(&pack, values->last_alarm_sensor ? values->last_alarm_sensor->address : 0);
+  alarmPackU8(&pack, zones);
+  STAILQ_FOREACH(zone, alarmZones, next) {
+    if ((zone->partition == partition) && (zones > 0)) {
+      alarmZoneValuesGet(zone, &zoneValues);
+      alarmPackU16(&pack, zoneValues.status);
+      alarmPackU8(&pack, (zoneValues.relay ? 1 : 0) | ((zoneValues.bypass & (AZB_BYPASS | AZB_INHIBIT)) << 1));
+      alarmPackU32(&pack, (uint32_t)zoneValues.last_set);
+      alarmPackU32(&pack, (uint32_t)zoneValues.last_clr);
+      zones--;
+    };
   };
+  alarmMqttPublishPacked(topic, &pack, CONFIG_ALARM_MQTT_STATUS_QOS, CONFIG_ALARM_MQTT_STATUS_RETAINED);
+  free(buf);
 }
 
-static void alarmMqttPublishEvent(alarmEventData_t event_data, bool publish_local)
+#endif // CONFIG_ALARM_MQTT_BINARY
+
+static void alarmMqttPublishEvent(const alarmEventValues_t* values)
 {
-  if (event_data.event->zone->topic && event_data.sensor->topic && esp_heap_free_check() && statesMqttIsEnabled()) {
+  if (values->zone_topic && values->sensor_topic && esp_heap_free_check() && statesMqttIsEnabled()) {
+    ALARM_STATS_START(mqttStart);
     char* topicSensor = nullptr;
-    alarmFormatTimestamps(event_data.event->event_last);
+    #if CONFIG_ALARM_MQTT_BINARY != 2
+      alarmTimestamp_t ts;
+      alarmFormatTimestamp(values->event_last, &ts);
+    #endif // CONFIG_ALARM_MQTT_BINARY
 
     // Basic data
     #if CONFIG_ALARM_MQTT_DEVICE_EVENTS
       topicSensor = mqttGetTopicDevice5(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_EVENTS_LOCAL,
-        CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_EVENTS_TOPIC, event_data.event->zone->topic, event_data.sensor->topic, 
-        alarmMqttEventTopic(event_data.event->type)); 
+        CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_EVENTS_TOPIC, values->zone_topic, values->sensor_topic, 
+        alarmMqttEventTopic(values->type)); 
     #else
       topicSensor = mqttGetTopicSpecial4(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_EVENTS_LOCAL,
-        CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_EVENTS_TOPIC, event_data.event->zone->topic, event_data.sensor->topic, 
-        alarmMqttEventTopic(event_data.event->type)); 
+        CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_EVENTS_TOPIC, values->zone_topic, values->sensor_topic, 
+        alarmMqttEventTopic(values->type)); 
     #endif // CONFIG_ALARM_MQTT_DEVICE_EVENTS
 
     if (topicSensor) {
       mqttPublish(mqttGetSubTopic(topicSensor, CONFIG_ALARM_MQTT_EVENTS_STATUS), 
-        malloc_stringf("%d", event_data.event->state), 
-        CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED, true, true);
-      mqttPublish(mqttGetSubTopic(topicSensor, CONFIG_ALARM_MQTT_EVENTS_JSON), 
-        malloc_stringf(CONFIG_ALARM_MQTT_EVENTS_JSON_TEMPLATE, 
-          event_data.event->state, _alarmTimestampL, _alarmTimestampS, _alarmTimestampU, event_data.event->events_count), 
+        malloc_stringf("%d", values->state), 
         CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED, true, true);
+      #if CONFIG_ALARM_MQTT_BINARY != 2
+        mqttPublish(mqttGetSubTopic(topicSensor, CONFIG_ALARM_MQTT_EVENTS_JSON), 
+          malloc_stringf(CONFIG_ALARM_MQTT_EVENTS_JSON_TEMPLATE, 
+            values->state, ts.ts_long, ts.ts_short, ts.ts_unix, values->events_count), 
+          CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED, true, true);
+      #endif // CONFIG_ALARM_MQTT_BINARY
+      #if CONFIG_ALARM_MQTT_BINARY
+        alarmMqttPackEvent(topicSensor, values);
+      #endif // CONFIG_ALARM_MQTT_BINARY
       free(topicSensor);
       topicSensor = nullptr;
     } else {
-      rlog_e(logTAG, "Failed to generate a topic for publishing an event \"%s\"", event_data.event->msg_set);
+      rlog_e(logTAG, "Failed to generate a topic for publishing an event \"%s\"", values->msg);
     }
 
     // Local data
-    if (publish_local && event_data.sensor->local_publish) {
+    if (values->publish_local) {
       topicSensor = mqttGetTopicSpecial3(statesMqttIsPrimary(), true,
-        CONFIG_ALARM_MQTT_SECURITY_TOPIC, event_data.event->zone->topic, event_data.sensor->topic, 
-        alarmMqttEventTopic(event_data.event->type)); 
+        CONFIG_ALARM_MQTT_SECURITY_TOPIC, values->zone_topic, values->sensor_topic, 
+        alarmMqttEventTopic(values->type)); 
       if (topicSensor) {
         mqttPublish(mqttGetSubTopic(topicSensor, CONFIG_ALARM_MQTT_EVENTS_STATUS), 
-          malloc_stringf("%d", event_data.event->state), 
-          CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED, true, true);
-        mqttPublish(mqttGetSubTopic(topicSensor, CONFIG_ALARM_MQTT_EVENTS_JSON), 
-          malloc_stringf(CONFIG_ALARM_MQTT_EVENTS_JSON_TEMPLATE, 
-            event_data.event->state, _alarmTimestampL, _alarmTimestampS, _alarmTimestampU, event_data.event->events_count), 
+          malloc_stringf("%d", values->state), 
           CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED, true, true);
+        #if CONFIG_ALARM_MQTT_BINARY != 2
+          mqttPublish(mqttGetSubTopic(topicSensor, CONFIG_ALARM_MQTT_EVENTS_JSON), 
+            malloc_stringf(CONFIG_ALARM_MQTT_EVENTS_JSON_TEMPLATE, 
+              values->state, ts.ts_long, ts.ts_short, ts.ts_unix, values->events_count), 
+            CONFIG_ALARM_MQTT_EVENTS_QOS, CONFIG_ALARM_MQTT_EVENTS_RETAINED, true, true);
+        #endif // CONFIG_ALARM_MQTT_BINARY
+        #if CONFIG_ALARM_MQTT_BINARY
+          alarmMqttPackEvent(topicSensor, values);
+        #endif // CONFIG_ALARM_MQTT_BINARY
         free(topicSensor);
         topicSensor = nullptr;
       } else {
-        rlog_e(logTAG, "Failed to generate a local topic for publishing an event \"%s\"", event_data.event->msg_set);
-      };
-    };
-    
-    // Calculate next post time
-    if (event_data.event->mqtt_interval > 0) {
-      event_data.event->mqtt_next = time(nullptr) + event_data.event->mqtt_interval;
+        rlog_e(logTAG, "Failed to generate a local topic for publishing an event \"%s\"", values->msg);
+      };
     };
+
+    ALARM_STATS_STOP(mqtt, mqttStart);
   };
 }
 
@@ -1531,9 +4519,10 @@ static void alarmMqttPublishEvents()
       if ( (sensor->events[i].type != ASE_EMPTY) 
         && (sensor->events[i].mqtt_interval > 0) 
         && (sensor->events[i].mqtt_next <= time(nullptr))) {
-          alarmEventData_t data = {sensor, &sensor->events[i]};
-          alarmMqttPublishEvent(data, false);
-          vTaskDelay(1);
+          alarmEventData_t data = {sensor, &sensor->events[i], 0};
+          if (!alarmMqttEventPost(data, false)) {
+            vTaskDelay(1);
+          };
       };
     };
   };
@@ -1545,16 +4534,66 @@ static void alarmMqttPublishEvents()
 
 static char* alarmMqttJsonZone(alarmZoneHandle_t zone)
 {
-  char buf_last_set[CONFIG_FORMAT_STRFTIME_DTS_BUFFER_SIZE];
-  char buf_last_clr[CONFIG_FORMAT_STRFTIME_DTS_BUFFER_SIZE];
-  time2str_empty(CONFIG_FORMAT_DTS, &(zone->last_set), buf_last_set, sizeof(buf_last_set));
-  time2str_empty(CONFIG_FORMAT_DTS, &(zone->last_clr), buf_last_clr, sizeof(buf_last_clr));
+  alarmZoneValues_t values;
+  alarmZoneValuesGet(zone, &values);
+  alarmTimestamp_t last_set, last_clr;
+  alarmFormatTimestamp(values.last_set, &last_set);
+  alarmFormatTimestamp(values.last_clr, &last_clr);
+
+  return malloc_stringf("\"%s\":{\"name\":\"%s\",\"status\":%d,\"last_alarm\":\"%s\",\"last_clear\":\"%s\",\"relay\":%d,\"bypass\":%d}",
+    zone->topic, zone->name, values.status, last_set.ts_dts, last_clr.ts_dts, values.relay, values.bypass);
+}
+
+// Forms a list of zones belonging to the partition
+static char* alarmMqttJsonZones(alarmPartitionHandle_t partition)
+{
+  char * jsonZones = nullptr;
+  char * jsonZone = nullptr;
+  char * jsonTemp = nullptr;
+  alarmZoneHandle_t zone;
+  STAILQ_FOREACH(zone, alarmZones, next) {
+    if (zone->partition == partition) {
+      jsonZone = alarmMqttJsonZone(zone);
+      if (jsonZone) {
+        if (jsonZones) {
+          jsonTemp = jsonZones;
+          jsonZones = malloc_stringf("%s,%s", jsonTemp, jsonZone);
+          free(jsonTemp);
+        } else {
+          jsonZones = malloc_string(jsonZone);
+        };
+        free(jsonZone);
+      };
+    };
+  };
+  return jsonZones;
+}
 
-  return malloc_stringf("\"%s\":{\"name\":\"%s\",\"status\":%d,\"last_alarm\":\"%s\",\"last_clear\":\"%s\",\"relay\":%d}",
-    zone->topic, zone->name, zone->status, buf_last_set, buf_last_clr, zone->relay_state);
+static const char* alarmModeChar(alarm_mode_t mode)
+{
+  switch (mode) {
+    case ASM_ARMED: 
+      return CONFIG_ALARM_MODE_CHAR_ARMED;
+    case ASM_PERIMETER:
+      return CONFIG_ALARM_MODE_CHAR_PERIMETER;
+    case ASM_OUTBUILDINGS:
+      return CONFIG_ALARM_MODE_CHAR_OUTBUILDINGS;
+    default:
+      return CONFIG_ALARM_MODE_CHAR_DISABLED;
+  };
 }
 
 static void alarmMqttPublishStatus()
+{
+  // Every change of the visible state ends up here, whichever task made it, so this is where the snapshot is refreshed
+  alarmSnapshotUpdate();
+  alarmEffect_t effect = { AEF_MQTT_STATUS, 0, false, nullptr, { nullptr, nullptr, 0 }, {}, {} };
+  alarmStatusValuesGet(&_alarmPartMain, &effect.status);
+  if (alarmEffectsPost(&effect)) return;
+  alarmMqttPublishStatusValues(&effect.status);
+}
+
+static void alarmMqttPublishStatusValues(const alarmStatusValues_t* values)
 {
   if (esp_heap_free_check() && statesMqttIsEnabled()) {
     char * topicStatus = nullptr;
@@ -1577,11 +4616,19 @@ static void alarmMqttPublishStatus()
       #endif // CONFIG_ALARM_MQTT_DEVICE_TOPIC
     #endif // CONFIG_ALARM_MQTT_DEVICE_STATUS
     RE_MEM_CHECK(topicStatus, return);
+    ALARM_STATS_START(mqttStart);
+
+    #if CONFIG_ALARM_MQTT_BINARY
+      alarmMqttPackStatus(topicStatus, values);
+      #if CONFIG_ALARM_MQTT_BINARY == 2
+        ALARM_STATS_STOP(mqtt, mqttStart);
+        free(topicStatus);
+        return;
+      #endif
+    #endif // CONFIG_ALARM_MQTT_BINARY
 
     char * jsonStatus = nullptr;
     char * jsonZones = nullptr;
-    char * jsonZone = nullptr;
-    char * jsonTemp = nullptr;
     char * statusSummary = nullptr;
     char * statusAnnunciator = nullptr;
     char * jsonLastAlarm = nullptr;
@@ -1590,101 +4637,83 @@ static void alarmMqttPublishStatus()
     // Getting names of sensors
     const char* sensorLastAlarm = nullptr;
     const char* sensorLastEvent = nullptr;
-    if (_alarmLastAlarmData.sensor) {
-      sensorLastAlarm = _alarmLastAlarmData.sensor->name;
+    if (values->last_alarm_sensor) {
+      sensorLastAlarm = values->last_alarm_sensor->name;
     } else {
       sensorLastAlarm = CONFIG_ALARM_MQTT_STATUS_DEVICE_EMPTY;
     };
-    if (_alarmLastEventData.sensor) {
-      sensorLastEvent = _alarmLastEventData.sensor->name;
+    if (values->last_event_sensor) {
+      sensorLastEvent = values->last_event_sensor->name;
     } else {
       sensorLastEvent = CONFIG_ALARM_MQTT_STATUS_DEVICE_EMPTY;
     };
 
-    // Forming an array with zones
-    alarmZoneHandle_t zone;
-    STAILQ_FOREACH(zone, alarmZones, next) {
-      jsonZone = alarmMqttJsonZone(zone);
-      if (jsonZone) {
-        if (jsonZones) {
-          jsonTemp = jsonZones;
-          jsonZones = malloc_stringf("%s,%s", jsonTemp, jsonZone);
-          free(jsonTemp);
-        } else {
-          jsonZones = malloc_string(jsonZone);
-        };
-        free(jsonZone);
-      };
-    };
+    // Forming an array with zones of the main partition
+    jsonZones = alarmMqttJsonZones(&_alarmPartMain);
 
     // Select mode labels
-    const char* sMode = CONFIG_ALARM_MODE_CHAR_DISABLED;
-    if (_alarmMode == ASM_ARMED) {
-      sMode = CONFIG_ALARM_MODE_CHAR_ARMED;        
-    } else if (_alarmMode == ASM_PERIMETER) {
-      sMode = CONFIG_ALARM_MODE_CHAR_PERIMETER;    
-    } else if (_alarmMode == ASM_OUTBUILDINGS) {
-      sMode = CONFIG_ALARM_MODE_CHAR_OUTBUILDINGS;
-    };
+    const char* sMode = alarmModeChar(values->mode);
 
     // Select annunciator labels
     const char* sAnnunciator = CONFIG_ALARM_ANNUNCIATOR_OFF;
-    if (_sirenActive) {
-      if (_flasherActive) {
+    if (values->siren) {
+      if (values->flasher) {
         sAnnunciator = CONFIG_ALARM_ANNUNCIATOR_TOTAL;
       } else {
         sAnnunciator = CONFIG_ALARM_ANNUNCIATOR_SIREN;
       };
     } else {
-      if (_flasherActive) {
+      if (values->flasher) {
         sAnnunciator = CONFIG_ALARM_ANNUNCIATOR_FLASHER;
       };
     };
 
     // Generate status line
-    statusSummary = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_SUMMARY, sMode, _alarmCount, sAnnunciator);
+    statusSummary = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_SUMMARY, sMode, values->count, sAnnunciator);
     RE_MEM_CHECK(statusSummary, goto finalize);
 
     // Generate annunciator status
-    statusAnnunciator = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_JSON_ANNUNCIATOR, _sirenActive, _flasherActive, _sirenActive << 1 | _flasherActive);
+    statusAnnunciator = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_JSON_ANNUNCIATOR, values->siren, values->flasher, values->siren << 1 | values->flasher);
     RE_MEM_CHECK(statusAnnunciator, goto finalize);
 
     // Generate last event data
-    alarmFormatTimestamps(_alarmLastEvent);
-    jsonLastEvent = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_JSON_ALARM, sensorLastEvent, _alarmTimestampL, _alarmTimestampS, _alarmTimestampU);
+    alarmTimestamp_t tsEvent;
+    alarmFormatTimestamp(values->last_event, &tsEvent);
+    jsonLastEvent = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_JSON_ALARM, sensorLastEvent, tsEvent.ts_long, tsEvent.ts_short, tsEvent.ts_unix);
     RE_MEM_CHECK(jsonLastEvent, goto finalize);
 
     // Generate last alarm data
-    alarmFormatTimestamps(_alarmLastAlarm);
-    jsonLastAlarm = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_JSON_ALARM, sensorLastAlarm, _alarmTimestampL, _alarmTimestampS, _alarmTimestampU);
+    alarmTimestamp_t tsAlarm;
+    alarmFormatTimestamp(values->last_alarm, &tsAlarm);
+    jsonLastAlarm = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_JSON_ALARM, sensorLastAlarm, tsAlarm.ts_long, tsAlarm.ts_short, tsAlarm.ts_unix);
     RE_MEM_CHECK(jsonLastAlarm, goto finalize);
 
     // Generate full JSON string
     #if CONFIG_ALARM_MQTT_STATUS_DISPLAY
       if (jsonZones) {
         jsonStatus = malloc_stringf("{\"mode\":%d,\"alarms\":%d,\"status\":\"%s\",\"annunciator\":%s,\"alarm\":%s,\"event\":%s,\"display\":\"%s\n%s\n%s\",\"zones\":{%s}}", 
-          _alarmMode, _alarmCount, 
+          values->mode, values->count, 
           statusSummary, statusAnnunciator, 
           jsonLastAlarm, jsonLastEvent, 
-          statusSummary, sensorLastAlarm, _alarmTimestampS,          
+          statusSummary, sensorLastAlarm, tsAlarm.ts_short,          
           jsonZones);
       } else {
         jsonStatus = malloc_stringf("{\"mode\":%d,\"alarms\":%d,\"status\":\"%s\",\"annunciator\":%s,\"alarm\":%s,\"event\":%s,\"display\":\"%s\n%s\n%s\",\"zones\":{}}", 
-          _alarmMode, _alarmCount, 
+          values->mode, values->count, 
           statusSummary, statusAnnunciator, 
           jsonLastAlarm, jsonLastEvent, 
-          statusSummary, sensorLastAlarm, _alarmTimestampS);
+          statusSummary, sensorLastAlarm, tsAlarm.ts_short);
       };
     #else
       if (jsonZones) {
         jsonStatus = malloc_stringf("{\"mode\":%d,\"alarms\":%d,\"status\":\"%s\",\"annunciator\":%s,\"alarm\":%s,\"event\":%s,\"zones\":{%s}}", 
-          _alarmMode, _alarmCount, 
+          values->mode, values->count, 
           statusSummary, statusAnnunciator, 
           jsonLastAlarm, jsonLastEvent, 
           jsonZones);
       } else {
         jsonStatus = malloc_stringf("{\"mode\":%d,\"alarms\":%d,\"status\":\"%s\",\"annunciator\":%s,\"alarm\":%s,\"event\":%s,\"zones\":{}}", 
-          _alarmMode, _alarmCount, 
+          values->mode, values->count, 
           statusSummary, statusAnnunciator, 
           jsonLastAlarm, jsonLastEvent);
       };
@@ -1693,6 +4722,7 @@ static void alarmMqttPublishStatus()
     
     mqttPublish(topicStatus, jsonStatus, 
       CONFIG_ALARM_MQTT_STATUS_QOS, CONFIG_ALARM_MQTT_STATUS_RETAINED, false, false);
+    ALARM_STATS_STOP(mqtt, mqttStart);
     goto finalize;
 
     // Free resources
@@ -1707,69 +4737,620 @@ static void alarmMqttPublishStatus()
   };
 }
 
+// Status of additional partitions is published in "security/<topic>/status"
+static void alarmMqttPublishPartition(alarmPartitionHandle_t partition)
+{
+  if (partition == &_alarmPartMain) {
+    alarmMqttPublishStatus();
+    return;
+  };
+
+  alarmSnapshotUpdate();
+  alarmEffect_t effect = { AEF_MQTT_PARTITION, 0, false, partition, { nullptr, nullptr, 0 }, {}, {} };
+  alarmStatusValuesGet(partition, &effect.status);
+  if (alarmEffectsPost(&effect)) return;
+  alarmMqttPublishPartitionValues(&effect.status);
+}
+
+static void alarmMqttPublishPartitionValues(const alarmStatusValues_t* values)
+{
+  alarmPartitionHandle_t partition = values->partition;
+  if (esp_heap_free_check() && statesMqttIsEnabled()) {
+    char * topicStatus = mqttGetTopicSpecial2(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_STATUS_LOCAL,
+      CONFIG_ALARM_MQTT_SECURITY_TOPIC, partition->topic, CONFIG_ALARM_MQTT_STATUS_TOPIC);
+    RE_MEM_CHECK(topicStatus, return);
+    ALARM_STATS_START(mqttStart);
+
+    #if CONFIG_ALARM_MQTT_BINARY
+      alarmMqttPackStatus(topicStatus, values);
+      #if CONFIG_ALARM_MQTT_BINARY == 2
+        ALARM_STATS_STOP(mqtt, mqttStart);
+        free(topicStatus);
+        return;
+      #endif
+    #endif // CONFIG_ALARM_MQTT_BINARY
+
+    const char* sAnnunciator = CONFIG_ALARM_ANNUNCIATOR_OFF;
+    if (values->annunciator && values->siren) {
+      sAnnunciator = values->flasher ? CONFIG_ALARM_ANNUNCIATOR_TOTAL : CONFIG_ALARM_ANNUNCIATOR_SIREN;
+    } else if (values->annunciator && values->flasher) {
+      sAnnunciator = CONFIG_ALARM_ANNUNCIATOR_FLASHER;
+    };
+
+    char * jsonZones = alarmMqttJsonZones(partition);
+    char * statusSummary = malloc_stringf(CONFIG_ALARM_MQTT_STATUS_SUMMARY, alarmModeChar(values->mode), values->count, sAnnunciator);
+    char * jsonStatus = nullptr;
+    if (statusSummary) {
+      jsonStatus = malloc_stringf("{\"name\":\"%s\",\"mode\":%d,\"alarms\":%d,\"status\":\"%s\",\"zones\":{%s}}", 
+        partition->name, values->mode, values->count, statusSummary, jsonZones ? jsonZones : "");
+    };
+    if (jsonStatus) {
+      mqttPublish(topicStatus, jsonStatus, 
+        CONFIG_ALARM_MQTT_STATUS_QOS, CONFIG_ALARM_MQTT_STATUS_RETAINED, false, false);
+      ALARM_STATS_STOP(mqtt, mqttStart);
+      free(jsonStatus);
+    };
+    if (statusSummary) free(statusSummary);
+    if (jsonZones) free(jsonZones);
+    free(topicStatus);
+  };
+}
+
+static void alarmMqttPublishPartitions()
+{
+  if (_alarmPartitions) {
+    alarmPartitionHandle_t partition;
+    STAILQ_FOREACH(partition, _alarmPartitions, next) {
+      alarmMqttPublishPartition(partition);
+    };
+  } else {
+    alarmMqttPublishStatus();
+  };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------ Web status -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * All handlers and the push work run in the HTTP server task, so one serialized buffer is shared by all clients without 
+ * locking. State changes only mark the status as changed; the alarm task queues the push work (at most one at a time and 
+ * not more often than CONFIG_ALARM_WEB_PUSH_INTERVAL). The work takes a snapshot, serializes it once (reAlarmWeb) and 
+ * sends the same frame to every WebSocket client
+ * */
+
+#if CONFIG_ALARM_WEB_ENABLE
+
+static httpd_handle_t _alarmWebServer = nullptr;
+static bool _alarmWebPending = false;
+static bool _alarmWebDirty = false;
+static int64_t _alarmWebLastPush = 0;
+static char _alarmWebBuffer[CONFIG_ALARM_WEB_BUFFER_SIZE];
+static size_t _alarmWebLength = 0;
+static alarmSnapshot_t _alarmWebSnapshot;
+static alarmWebDelta_t _alarmWebDelta;
+
+static esp_err_t alarmWebStatusHandler(httpd_req_t *req)
+{
+  alarmSnapshotGet(&_alarmWebSnapshot);
+  _alarmWebLength = alarmWebFormat(&_alarmWebSnapshot, nullptr, _alarmWebBuffer, sizeof(_alarmWebBuffer));
+  if (_alarmWebLength == 0) {
+    rlog_e(logTAG, "Web status buffer is too small");
+    httpd_resp_send_500(req);
+    return ESP_FAIL;
+  };
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  return httpd_resp_send(req, _alarmWebBuffer, _alarmWebLength);
+}
+
+#if CONFIG_HTTPD_WS_SUPPORT
+
+static esp_err_t alarmWebSocketHandler(httpd_req_t *req)
+{
+  httpd_ws_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.type = HTTPD_WS_TYPE_TEXT;
+
+  // Handshake is done: the new client gets the full status
+  if (req->method == HTTP_GET) {
+    alarmSnapshotGet(&_alarmWebSnapshot);
+    _alarmWebLength = alarmWebFormat(&_alarmWebSnapshot, nullptr, _alarmWebBuffer, sizeof(_alarmWebBuffer));
+    if (_alarmWebLength == 0) return ESP_FAIL;
+    frame.payload = (uint8_t*)_alarmWebBuffer;
+    frame.len = _alarmWebLength;
+    return httpd_ws_send_frame(req, &frame);
+  };
+
+  // Incoming frames are not used, but they have to be read out
+  uint8_t buf[32];
+  esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+  if ((err == ESP_OK) && (frame.len > 0)) {
+    if (frame.len > sizeof(buf)) return ESP_FAIL;
+    frame.payload = buf;
+    err = httpd_ws_recv_frame(req, &frame, frame.len);
+  };
+  return err;
+}
+
+static void alarmWebPushWork(void* arg)
+{
+  __atomic_store_n(&_alarmWebPending, false, __ATOMIC_RELEASE);
+  httpd_handle_t server = _alarmWebServer;
+  if (!server) return;
+
+  alarmSnapshotGet(&_alarmWebSnapshot);
+  int len = alarmWebDeltaFormat(&_alarmWebDelta, &_alarmWebSnapshot, _alarmWebBuffer, sizeof(_alarmWebBuffer));
+  if (len < 0) {
+    rlog_e(logTAG, "Web status buffer is too small");
+    return;
+  };
+  if (len == 0) return;
+  _alarmWebLength = len;
+
+  int clients[CONFIG_ALARM_WEB_MAX_CLIENTS];
+  size_t count = CONFIG_ALARM_WEB_MAX_CLIENTS;
+  if (httpd_get_client_list(server, &count, clients) != ESP_OK) return;
+  httpd_ws_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.type = HTTPD_WS_TYPE_TEXT;
+  frame.payload = (uint8_t*)_alarmWebBuffer;
+  frame.len = _alarmWebLength;
+  for (size_t i = 0; i < count; i++) {
+    if (httpd_ws_get_fd_info(server, clients[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+      httpd_ws_send_frame_async(server, clients[i], &frame);
+    };
+  };
+}
+
+#endif // CONFIG_HTTPD_WS_SUPPORT
+
+// Called by the alarm task only: queues the push work if the status has changed and the interval has passed
+static void alarmWebFlush()
+{
+  #if CONFIG_HTTPD_WS_SUPPORT
+    httpd_handle_t server = _alarmWebServer;
+    if (!server || !__atomic_load_n(&_alarmWebDirty, __ATOMIC_ACQUIRE)) return;
+    int64_t now = esp_timer_get_time();
+    if ((now - _alarmWebLastPush) < (int64_t)CONFIG_ALARM_WEB_PUSH_INTERVAL * 1000) return;
+    __atomic_store_n(&_alarmWebDirty, false, __ATOMIC_RELEASE);
+    _alarmWebLastPush = now;
+    // Work that is already queued will take the latest snapshot
+    if (!__atomic_exchange_n(&_alarmWebPending, true, __ATOMIC_ACQ_REL)) {
+      if (httpd_queue_work(server, alarmWebPushWork, nullptr) != ESP_OK) {
+        __atomic_store_n(&_alarmWebPending, false, __ATOMIC_RELEASE);
+        __atomic_store_n(&_alarmWebDirty, true, __ATOMIC_RELEASE);
+      };
+    };
+  #endif // CONFIG_HTTPD_WS_SUPPORT
+}
+
+// Called on every snapshot update from any task; other tasks leave the push to the periodic tasks of the alarm task
+static void alarmWebNotify()
+{
+  __atomic_store_n(&_alarmWebDirty, true, __ATOMIC_RELEASE);
+  if (xTaskGetCurrentTaskHandle() == _alarmTask) {
+    alarmWebFlush();
+  };
+}
+
+bool alarmWebRegister(httpd_handle_t server)
+{
+  if (!server) return false;
+  httpd_uri_t uri;
+  memset(&uri, 0, sizeof(uri));
+  uri.uri = CONFIG_ALARM_WEB_STATUS_URI;
+  uri.method = HTTP_GET;
+  uri.handler = alarmWebStatusHandler;
+  esp_err_t err = httpd_register_uri_handler(server, &uri);
+  if (err != ESP_OK) {
+    rlog_e(logTAG, "Failed to register web status handler: %d %s", err, esp_err_to_name(err));
+    return false;
+  };
+  #if CONFIG_HTTPD_WS_SUPPORT
+    uri.uri = CONFIG_ALARM_WEB_SOCKET_URI;
+    uri.handler = alarmWebSocketHandler;
+    uri.is_websocket = true;
+    err = httpd_register_uri_handler(server, &uri);
+    if (err != ESP_OK) {
+      rlog_e(logTAG, "Failed to register web socket handler: %d %s", err, esp_err_to_name(err));
+      httpd_unregister_uri_handler(server, CONFIG_ALARM_WEB_STATUS_URI, HTTP_GET);
+      return false;
+    };
+  #endif // CONFIG_HTTPD_WS_SUPPORT
+  alarmWebDeltaReset(&_alarmWebDelta);
+  _alarmWebServer = server;
+  rlog_i(logTAG, "Web status registered at \"%s\"", CONFIG_ALARM_WEB_STATUS_URI);
+  return true;
+}
+
+void alarmWebUnregister()
+{
+  httpd_handle_t server = _alarmWebServer;
+  if (server) {
+    _alarmWebServer = nullptr;
+    httpd_unregister_uri_handler(server, CONFIG_ALARM_WEB_STATUS_URI, HTTP_GET);
+    #if CONFIG_HTTPD_WS_SUPPORT
+      httpd_unregister_uri_handler(server, CONFIG_ALARM_WEB_SOCKET_URI, HTTP_GET);
+    #endif // CONFIG_HTTPD_WS_SUPPORT
+  };
+}
+
+#else
+
+static inline void alarmWebNotify() {}
+static inline void alarmWebFlush() {}
+
+#endif // CONFIG_ALARM_WEB_ENABLE
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------ Commands -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Command names come from the configuration, so the dispatch table is built at startup: the seed of the slot function 
+ * is chosen so that every command gets a slot of its own. A lookup costs one hash and one comparison regardless of 
+ * the number of commands. Replies go back through the callback of the channel the command came from
+ * */
+
+typedef struct {
+  cb_alarm_command_reply_t cb;
+  void* ctx;
+} alarmCommandReply_t;
+
+struct alarmCommand_t;
+typedef void (*alarm_command_handler_t) (const struct alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply);
+
+typedef struct alarmCommand_t {
+  const char* name;
+  alarm_command_handler_t handler;
+  uint32_t param;
+} alarmCommand_t;
+
+static void alarmCommandReply(alarmCommandReply_t* reply, const char* format, ...)
+{
+  if (reply && reply->cb) {
+    char msg[CONFIG_ALARM_COMMAND_REPLY_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(msg, sizeof(msg), format, args);
+    va_end(args);
+    reply->cb(msg, reply->ctx);
+  };
+}
+
+// Partition argument: nullptr if omitted, false if not found
+static bool alarmCommandPartition(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply, alarmPartitionHandle_t* partition)
+{
+  *partition = nullptr;
+  if (arg) {
+    *partition = alarmPartitionFind(arg);
+    if (!*partition) {
+      rlog_w(logTAG, "Partition [ %s ] not found", arg);
+      alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_NOT_FOUND, command->name, arg);
+      return false;
+    };
+  };
+  return true;
+}
+
+static void alarmCommandReplyPartition(alarmPartitionHandle_t partition, alarmCommandReply_t* reply)
+{
+  alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_PARTITION, partition->name, alarmModeText(partition->mode), partition->count);
+}
+
+static void alarmCommandMode(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply)
+{
+  alarmPartitionHandle_t partition;
+  if (alarmCommandPartition(command, arg, reply, &partition)) {
+    alarmPartitionHandle_t target = partition ? partition : &_alarmPartMain;
+    alarmModeChange(target, (alarm_mode_t)command->param, ACC_COMMANDS, nullptr, true, true);
+    alarmCommandReplyPartition(target, reply);
+  };
+}
+
+// Without a partition, the alarm is canceled in all partitions; param - also clear events
+static void alarmCommandCancel(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply)
+{
+  alarmPartitionHandle_t partition;
+  if (alarmCommandPartition(command, arg, reply, &partition)) {
+    alarmAlarmCancel(partition, CONFIG_ALARM_SOURCE_COMMAND);
+    if (command->param) {
+      rlog_d(logTAG, "Cancel alarm and clear events remotely");
+      alarmAlarmsReset(partition, CONFIG_ALARM_SOURCE_COMMAND);
+    } else {
+      rlog_d(logTAG, "Cancel alarm remotely");
+    };
+    alarmMqttPublishPartitions();
+    alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_OK, command->name);
+  };
+}
+
+static void alarmCommandBypass(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply)
+{
+  if (alarmBypassCommand((uint8_t)command->param, arg)) {
+    alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_OK, command->name);
+  } else {
+    alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_NOT_FOUND, command->name, arg ? arg : "");
+  };
+}
+
+static void alarmCommandTrace(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply)
+{
+  alarmTraceDump();
+  alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_OK, command->name);
+}
+
+// Argument: partition or zone topic; without it - all partitions
+static void alarmCommandStatus(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply)
+{
+  if (arg) {
+    alarmPartitionHandle_t partition = alarmPartitionFind(arg);
+    if (partition) {
+      alarmCommandReplyPartition(partition, reply);
+      return;
+    };
+    alarmZoneHandle_t zone = alarmZoneFind(arg);
+    if (zone) {
+      alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_ZONE, zone->name, zone->status, zone->bypass, 
+        zone->partition ? zone->partition->name : _alarmPartMain.name);
+      return;
+    };
+    alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_NOT_FOUND, command->name, arg);
+  } else if (_alarmPartitions) {
+    alarmPartitionHandle_t partition;
+    STAILQ_FOREACH(partition, _alarmPartitions, next) {
+      alarmCommandReplyPartition(partition, reply);
+    };
+  } else {
+    alarmCommandReplyPartition(&_alarmPartMain, reply);
+  };
+}
+
+// Argument: new siren duration in seconds; without it - the current duration
+static void alarmCommandSiren(const alarmCommand_t* command, const char* arg, alarmCommandReply_t* reply)
+{
+  if (arg) {
+    uint32_t duration = strtoul(arg, nullptr, 10);
+    if (duration < CONFIG_ALARM_PARAMS_MIN_DURATION) duration = CONFIG_ALARM_PARAMS_MIN_DURATION;
+    if (duration > CONFIG_ALARM_PARAMS_MAX_DURATION) duration = CONFIG_ALARM_PARAMS_MAX_DURATION;
+    if (duration != _sirenDuration) {
+      _sirenDuration = duration;
+      if (_sirenDurationParam) {
+        paramsValueStore(_sirenDurationParam, false);
+      };
+    };
+  };
+  alarmCommandReply(reply, CONFIG_ALARM_COMMAND_REPLY_SIREN, _sirenDuration);
+}
+
+static const alarmCommand_t _alarmCommands[] = {
+  { CONFIG_ALARM_COMMAND_MODE_DISABLED,     alarmCommandMode,   ASM_DISABLED },
+  { CONFIG_ALARM_COMMAND_MODE_ARMED,        alarmCommandMode,   ASM_ARMED },
+  { CONFIG_ALARM_COMMAND_MODE_PERIMETER,    alarmCommandMode,   ASM_PERIMETER },
+  { CONFIG_ALARM_COMMAND_MODE_OUTBUILDINGS, alarmCommandMode,   ASM_OUTBUILDINGS },
+  { CONFIG_ALARM_COMMAND_ALARM_CANCEL,      alarmCommandCancel, 0 },
+  { CONFIG_ALARM_COMMAND_ALARM_RESET,       alarmCommandCancel, 1 },
+  { CONFIG_ALARM_COMMAND_BYPASS,            alarmCommandBypass, AZB_BYPASS },
+  { CONFIG_ALARM_COMMAND_INHIBIT,           alarmCommandBypass, AZB_INHIBIT },
+  { CONFIG_ALARM_COMMAND_RESTORE,           alarmCommandBypass, AZB_NONE },
+  { CONFIG_ALARM_COMMAND_STATUS,            alarmCommandStatus, 0 },
+  { CONFIG_ALARM_COMMAND_SIREN,             alarmCommandSiren,  0 },
+  { CONFIG_ALARM_COMMAND_TRACE_DUMP,        alarmCommandTrace,  0 }
+};
+#define ALARM_COMMANDS_COUNT (sizeof(_alarmCommands) / sizeof(alarmCommand_t))
+
+static_assert((CONFIG_ALARM_COMMAND_HASH_SIZE & (CONFIG_ALARM_COMMAND_HASH_SIZE - 1)) == 0, "CONFIG_ALARM_COMMAND_HASH_SIZE must be a power of two");
+
+// Slot contains the command index + 1, 0 - empty
+static uint8_t _alarmCommandSlots[CONFIG_ALARM_COMMAND_HASH_SIZE];
+static uint32_t _alarmCommandSeed = 0;
+static bool _alarmCommandsReady = false;
+
+static inline uint32_t alarmCommandSlot(uint32_t hash, uint32_t seed)
+{
+  hash ^= seed * 2654435761u;
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3bu;
+  hash ^= hash >> 16;
+  return hash & (CONFIG_ALARM_COMMAND_HASH_SIZE - 1);
+}
+
+// Commands are optional: a duplicate name is skipped, and if the table cannot be built, only the commands are unavailable
+static void alarmCommandsInit()
+{
+  if (_alarmCommandsReady) return;
+  uint32_t hashes[ALARM_COMMANDS_COUNT];
+  bool skip[ALARM_COMMANDS_COUNT];
+  for (uint8_t i = 0; i < ALARM_COMMANDS_COUNT; i++) {
+    size_t len = strlen(_alarmCommands[i].name);
+    hashes[i] = alarmHashString(_alarmCommands[i].name, len);
+    skip[i] = false;
+    for (uint8_t j = 0; j < i; j++) {
+      if (!skip[j] && (hashes[j] == hashes[i]) && (strlen(_alarmCommands[j].name) == len) 
+       && alarmTopicEqual(_alarmCommands[j].name, _alarmCommands[i].name, len)) {
+        rlog_e(logTAG, "Duplicate command name [ %s ] skipped", _alarmCommands[i].name);
+        skip[i] = true;
+        break;
+      };
+    };
+  };
+  for (uint32_t seed = 0; seed < 1024; seed++) {
+    memset(_alarmCommandSlots, 0, sizeof(_alarmCommandSlots));
+    uint8_t i = 0;
+    while (i < ALARM_COMMANDS_COUNT) {
+      if (!skip[i]) {
+        uint8_t* slot = &_alarmCommandSlots[alarmCommandSlot(hashes[i], seed)];
+        if (*slot) break;
+        *slot = i + 1;
+      };
+      i++;
+    };
+    if (i == ALARM_COMMANDS_COUNT) {
+      _alarmCommandSeed = seed;
+      _alarmCommandsReady = true;
+      return;
+    };
+  };
+  rlog_e(logTAG, "Failed to build the command table, increase CONFIG_ALARM_COMMAND_HASH_SIZE");
+}
+
+bool alarmCommandExec(const char* command, cb_alarm_command_reply_t reply, void* ctx)
+{
+  if (!command || !_alarmCommandsReady) return false;
+  while (*command == ' ') command++;
+  const char* end = command;
+  while (*end && (*end != ' ')) end++;
+  size_t len = end - command;
+  if ((len == 0) || (len >= CONFIG_ALARM_COMMAND_MAX_LEN)) return false;
+
+  uint8_t index = _alarmCommandSlots[alarmCommandSlot(alarmHashString(command, len), _alarmCommandSeed)];
+  if (index == 0) return false;
+  const alarmCommand_t* item = &_alarmCommands[index - 1];
+  if (!alarmTopicEqual(item->name, command, len)) return false;
+
+  while (*end == ' ') end++;
+  alarmCommandReply_t context = { reply, ctx };
+  item->handler(item, *end ? end : nullptr, &context);
+  return true;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------
 // ---------------------------------------------------- Event handlers ---------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
 bool alarmPostQueueExtId(source_type_t source, uint32_t id, uint8_t value)
 {
-  input_data_t queue_data;
-  memset(&queue_data, 0, sizeof(input_data_t));
-  queue_data.source = source;
-  queue_data.count = 1;
-  queue_data.ext.id = id;
-  queue_data.ext.value = value;
-  return xQueueSend(_alarmQueue, &queue_data, portMAX_DELAY) == pdPASS;
+  alarmInput_t queue_data;
+  memset(&queue_data, 0, sizeof(alarmInput_t));
+  queue_data.timestamp = esp_timer_get_time();
+  queue_data.data.source = source;
+  queue_data.data.count = 1;
+  queue_data.data.ext.id = id;
+  queue_data.data.ext.value = value;
+  return alarmQueuePost(&queue_data);
+}
+
+// Places values into the bulk ring under a single lock, displaced values are counted by the caller. 
+// The lock is held for at most one ring of values: the oldest values of a longer batch would be displaced by the newer ones 
+// of the same batch, so they are counted as displaced without being copied
+static uint16_t alarmPostQueueExtPush(const alarmExtValue_t* values, uint16_t count, bool displace, uint16_t* displaced)
+{
+  alarmInput_t queue_data;
+  memset(&queue_data, 0, sizeof(alarmInput_t));
+  queue_data.timestamp = esp_timer_get_time();
+  queue_data.data.count = 1;
+
+  uint16_t accepted = 0;
+  if (displace && (count > _alarmRingBulk.size)) {
+    accepted = count - _alarmRingBulk.size;
+    *displaced += accepted;
+    ALARM_STATS_ADD(queue_bulk_dropped, accepted);
+  };
+  portENTER_CRITICAL(&_alarmRingLock);
+  while (accepted < count) {
+    if (displace && ((_alarmRingBulk.head - _alarmRingBulk.tail) >= _alarmRingBulk.size)) {
+      (*displaced)++;
+    };
+    queue_data.data.source = values[accepted].source;
+    queue_data.data.ext.id = values[accepted].id;
+    queue_data.data.ext.value = values[accepted].value;
+    if (!alarmRingPushLocked(&_alarmRingBulk, &queue_data, displace)) break;
+    accepted++;
+  };
+  portEXIT_CRITICAL(&_alarmRingLock);
+
+  if (accepted > 0) {
+    xSemaphoreGive(_alarmQueueBell);
+  };
+  return accepted;
+}
+
+// Wired and radio inputs have their own queues and preprocessing (debounce, packet assembly)
+static bool alarmPostQueueExtCheck(const alarmExtValue_t* values, uint16_t count)
+{
+  for (uint16_t i = 0; i < count; i++) {
+    if ((values[i].source == IDS_GPIO) || (values[i].source == IDS_RX433)) {
+      rlog_e(logTAG, "External values batch rejected: invalid source %d at index %d", values[i].source, i);
+      return false;
+    };
+  };
+  return true;
+}
+
+uint16_t alarmPostQueueExtBatch(const alarmExtValue_t* values, uint16_t count, bool displace, uint16_t* displaced)
+{
+  uint16_t lost = 0;
+  uint16_t accepted = 0;
+  if (_alarmQueueBell && values && (count > 0) && alarmPostQueueExtCheck(values, count)) {
+    // The whole batch is placed under a single lock and followed by a single wake-up of the task
+    accepted = alarmPostQueueExtPush(values, count, displace, &lost);
+    if (lost > 0) {
+      rlog_w(logTAG, "Bulk queue overflow: %d oldest values displaced", lost);
+    };
+  };
+  if (displaced) *displaced = lost;
+  return accepted;
+}
+
+uint16_t alarmPostQueueExtBatchWait(const alarmExtValue_t* values, uint16_t count, TickType_t wait)
+{
+  if (!_alarmQueueBell || !values || (count == 0) || !alarmPostQueueExtCheck(values, count)) return 0;
+  uint16_t dummy = 0;
+  TickType_t start = xTaskGetTickCount();
+  uint16_t accepted = alarmPostQueueExtPush(values, count, false, &dummy);
+  // Values are never displaced: wait for the task to free up space, the same way as wired inputs do
+  while ((accepted < count) && ((wait == portMAX_DELAY) || ((xTaskGetTickCount() - start) < wait))) {
+    vTaskDelay(1);
+    accepted += alarmPostQueueExtPush(values + accepted, count - accepted, false, &dummy);
+  };
+  return accepted;
 }
 
 static void alarmGpioEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
   // Get GPIO signals from main event loop and redirect in mixed input stream
   if ((event_id == RE_GPIO_CHANGE) && (event_data)) {
-    input_data_t queue_data;
-    memset(&queue_data, 0, sizeof(input_data_t));
-    queue_data.source = IDS_GPIO;
-    queue_data.count = 1;
-    memcpy(&queue_data.gpio, event_data, sizeof(gpio_data_t));
-    xQueueSend(_alarmQueue, &queue_data, portMAX_DELAY);
+    alarmInput_t queue_data;
+    memset(&queue_data, 0, sizeof(alarmInput_t));
+    queue_data.timestamp = esp_timer_get_time();
+    queue_data.data.source = IDS_GPIO;
+    queue_data.data.count = 1;
+    memcpy(&queue_data.data.gpio, event_data, sizeof(gpio_data_t));
+    alarmQueuePost(&queue_data);
   };
 }
 
 static void alarmMqttEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
   if (event_id == RE_MQTT_CONNECTED) {
-    alarmMqttPublishStatus();
+    alarmMqttPublishPartitions();
+  };
+}
+
+static void alarmCommandReplyMqtt(const char* reply, void* ctx)
+{
+  if (esp_heap_free_check() && statesMqttIsEnabled()) {
+    char* topic = mqttGetTopicSpecial1(statesMqttIsPrimary(), CONFIG_ALARM_MQTT_REPLY_LOCAL, 
+      CONFIG_ALARM_MQTT_SECURITY_TOPIC, CONFIG_ALARM_MQTT_REPLY_TOPIC);
+    if (topic) {
+      mqttPublish(topic, malloc_string(reply), CONFIG_ALARM_MQTT_REPLY_QOS, false, true, true);
+    };
   };
 }
 
 static void alarmCommandsEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
   if ((event_id == RE_SYS_COMMAND) && (event_data != nullptr)) {
-    char* cmd = (char*)event_data;
-    if (strcasecmp(cmd, CONFIG_ALARM_COMMAND_MODE_DISABLED) == 0) {
-      alarmModeChange(ASM_DISABLED, ACC_COMMANDS, nullptr, true, true);
-    } else if (strcasecmp(cmd, CONFIG_ALARM_COMMAND_MODE_ARMED) == 0) {
-      alarmModeChange(ASM_ARMED, ACC_COMMANDS, nullptr, true, true);
-    } else if (strcasecmp(cmd, CONFIG_ALARM_COMMAND_MODE_PERIMETER) == 0) {
-      alarmModeChange(ASM_PERIMETER, ACC_COMMANDS, nullptr, true, true);
-    } else if (strcasecmp(cmd, CONFIG_ALARM_COMMAND_MODE_OUTBUILDINGS) == 0) {
-      alarmModeChange(ASM_OUTBUILDINGS, ACC_COMMANDS, nullptr, true, true);
-    } else if (strcasecmp(cmd, CONFIG_ALARM_COMMAND_ALARM_CANCEL) == 0) {
-      rlog_d(logTAG, "Cancel alarm remotely");
-      alarmAlarmCancel(CONFIG_ALARM_SOURCE_COMMAND);
-      alarmMqttPublishStatus();
-    } else if (strcasecmp(cmd, CONFIG_ALARM_COMMAND_ALARM_RESET) == 0) {
-      rlog_d(logTAG, "Cancel alarm and clear events remotely");
-      alarmAlarmCancel(CONFIG_ALARM_SOURCE_COMMAND);
-      alarmAlarmsReset(CONFIG_ALARM_SOURCE_COMMAND);
-      alarmMqttPublishStatus();
-    };
+    alarmCommandExec((const char*)event_data, alarmCommandReplyMqtt, nullptr);
   };
 }
 
+// Event records are released even while the task is suspended, so their handler lives as long as the task
 static bool alarmTaskRegisterHandlers(bool gpio_handler)
 {
   return (!gpio_handler || eventHandlerRegister(RE_GPIO_EVENTS, RE_GPIO_CHANGE, &alarmGpioEventHandler, nullptr))
+      && (!gpio_handler || eventHandlerRegister(RE_ALARM_EVENTS, RE_ALARM_RECORD_RELEASE, &alarmEventRecordEventHandler, nullptr))
       && eventHandlerRegister(RE_MQTT_EVENTS, RE_MQTT_CONNECTED, &alarmMqttEventHandler, nullptr)
       && eventHandlerRegister(RE_SYSTEM_EVENTS, RE_SYS_COMMAND, &alarmCommandsEventHandler, nullptr);
 }
@@ -1778,6 +5359,7 @@ static void alarmTaskUnregisterHandlers(bool gpio_handler)
 {
   if (gpio_handler) {
     eventHandlerUnregister(RE_GPIO_EVENTS, ESP_EVENT_ANY_ID, &alarmGpioEventHandler);
+    eventHandlerUnregister(RE_ALARM_EVENTS, RE_ALARM_RECORD_RELEASE, &alarmEventRecordEventHandler);
   };
   eventHandlerUnregister(RE_MQTT_EVENTS, RE_MQTT_CONNECTED, &alarmMqttEventHandler);
   eventHandlerUnregister(RE_SYSTEM_EVENTS, RE_SYS_COMMAND, &alarmCommandsEventHandler);
@@ -1791,17 +5373,76 @@ static void alarmTaskExecPeriodic()
 {
   // Periodic sending of data from sensors to mqtt
   alarmMqttPublishEvents();
+  // Close the jamming detector window, even if there are no packets
+  alarmJammingCheck(false, true);
+  // Remove expired bypasses
+  alarmBypassExpire();
+  // Check sensors supervision
+  alarmSupervisionProcess();
+  // Periodic publication of statistics
+  alarmStatsPublish();
+  // Statistics of sensor events, one sensor per call
+  alarmEventStatsPublish();
+  // Status changes made by other tasks and pushes postponed by the interval
+  alarmWebFlush();
+}
+
+// Classes are taken strictly in order: wired inputs, RX433, external values
+static bool alarmQueueReceive(alarmInput_t* input, TickType_t wait)
+{
+  TickType_t start = xTaskGetTickCount();
+  while (1) {
+    if (alarmRingPop(&_alarmRingAlarm, input)) {
+      alarmStatsQueue(AQC_ALARM);
+      return true;
+    };
+    // The driver queue is read only through the queue set, so that the set stays consistent
+    bool bulk = _alarmRingBulk.head != _alarmRingBulk.tail;
+    QueueSetMemberHandle_t queue = xQueueSelectFromSet(_alarmQueueSet, bulk ? 0 : wait);
+    if (queue == _alarmQueue) {
+      if (xQueueReceive(_alarmQueue, &input->data, 0) == pdPASS) {
+        input->timestamp = esp_timer_get_time();
+        alarmStatsQueue(AQC_CONTROL);
+        return true;
+      };
+    } else if (queue == _alarmQueueBell) {
+      // New inputs in the rings: check them again from the highest class. The bell may be stale (the inputs were 
+      // already taken on the previous pass), then the wait continues for the remaining time, a timeout is not reported early
+      xSemaphoreTake(_alarmQueueBell, 0);
+      if (wait != portMAX_DELAY) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        wait = (elapsed < wait) ? wait - elapsed : 0;
+        start += elapsed;
+      };
+      continue;
+    };
+    if (alarmRingPop(&_alarmRingBulk, input)) {
+      alarmStatsQueue(AQC_BULK);
+      return true;
+    };
+    return false;
+  };
 }
 
 static void alarmTaskExec(void *pvParameters)
 {
-  static input_data_t data, buf433;
+  static alarmInput_t input;
+  static input_data_t buf433;
+  static int64_t buf433_ts = 0;
   static bool rx433_processed = false;
+  input_data_t& data = input.data;
   static TickType_t queueWait = pdMS_TO_TICKS(1000);
 
   memset(&buf433, 0, sizeof(input_data_t));
+  alarmSnapshotUpdate();
   while (1) {
-    if (xQueueReceive(_alarmQueue, &data, queueWait) == pdPASS) {
+    // Entry and exit delays and debounce deadlines are scheduled by the task itself, without separate timers
+    uint32_t delayWait = alarmZonesDelaysProcess();
+    uint32_t debounceWait = alarmDebounceProcess();
+    if (debounceWait < delayWait) delayWait = debounceWait;
+    TickType_t wait = (delayWait < pdTICKS_TO_MS(queueWait)) ? pdMS_TO_TICKS(delayWait) : queueWait;
+    if (alarmQueueReceive(&input, wait)) {
+
       // Send signal to LED
       if ((data.source == IDS_RX433) && (_ledRx433)) {
         ledTaskSend(_ledRx433, lmFlash, CONFIG_ALARM_INCOMING_QUANTITY, CONFIG_ALARM_INCOMING_DURATION, CONFIG_ALARM_INCOMING_INTERVAL);
@@ -1810,7 +5451,10 @@ static void alarmTaskExec(void *pvParameters)
       // Handling signals from GPIO
       if (data.source == IDS_GPIO) {
         // rlog_d(logTAG, "Process GPIO signal: bus=%d, address=0x%.2X, gpio=%d, value=%d", data.gpio.bus, data.gpio.address, data.gpio.pin, data.gpio.value);
-        alarmProcessIncomingData(&data, true);
+        // Bounces are discarded before matching, confirmed levels are processed by alarmDebounceProcess()
+        if (alarmDebounceFilter(&data, input.timestamp)) {
+          alarmProcessIncomingData(&data, input.timestamp, true);
+        };
         alarmTaskExecPeriodic();
       }
       
@@ -1822,23 +5466,25 @@ static void alarmTaskExec(void *pvParameters)
           // If the number of signals has exceeded the threshold, send it for processing
           if (!rx433_processed && (buf433.count == CONFIG_ALARM_THRESHOLD_RF)) {
             // rlog_d(logTAG, "Process RX433 signal (threshold): protocol=%d, value=0x%.8X, count=%d", buf433.rx433.value, buf433.rx433.value, buf433.count);
-            rx433_processed = alarmProcessIncomingData(&buf433, false);
+            rx433_processed = alarmProcessIncomingData(&buf433, buf433_ts, false);
           };
         } else {
           // If the previous signal was not processed, send it for processing
           if ((buf433.source == IDS_RX433) && (buf433.rx433.value > 0) && (buf433.count > 0) && !rx433_processed) {
             // rlog_d(logTAG, "Process RX433 signal (changed): protocol=%d, value=0x%.8X, count=%d", buf433.rx433.value, buf433.rx433.value, buf433.count);
-            alarmProcessIncomingData(&buf433, true);
+            alarmProcessIncomingData(&buf433, buf433_ts, true);
           };
+          alarmEventStatsPacketEnd(buf433.count);
           // Set new data to last and reset the counter (we don't really need it), instead we will count the number of packets
           memcpy(&buf433, &data, sizeof(input_data_t));
+          buf433_ts = input.timestamp;
           buf433.count = 1;
           rx433_processed = false;
           // rlog_d(logTAG, "Init new RX433 signal: protocol=%d, value=0x%.8X, count=%d", buf433.rx433.value, buf433.rx433.value, buf433.count);
           // If the threshold is not set, process the signal immediately
           if (buf433.count == CONFIG_ALARM_THRESHOLD_RF) {
             // rlog_d(logTAG, "Process RX433 signal (threshold): protocol=%d, value=0x%.8X, count=%d", buf433.rx433.value, buf433.rx433.value, buf433.count);
-            rx433_processed = alarmProcessIncomingData(&buf433, false);
+            rx433_processed = alarmProcessIncomingData(&buf433, buf433_ts, false);
           };
         };
         
@@ -1849,7 +5495,7 @@ static void alarmTaskExec(void *pvParameters)
       // Handling others non-repeating signals
       else if (data.source > IDS_NONE) {
         // rlog_d(logTAG, "Process signal (EXTERNAL): source=%d, count=%d", data.source, data.count);
-        alarmProcessIncomingData(&data, true);
+        alarmProcessIncomingData(&data, input.timestamp, true);
         alarmTaskExecPeriodic();
       } 
       
@@ -1858,14 +5504,15 @@ static void alarmTaskExec(void *pvParameters)
         rlog_e(logTAG, "Signal received from RTM_NONE!");
         alarmTaskExecPeriodic();
       };
-    } else {
+    } else if (wait == queueWait) {
       // End of transmission, push the previous signal for further processing
       if (!rx433_processed) {
         if ((buf433.source == IDS_RX433) && (buf433.rx433.value > 0) && (buf433.count > 0)) {
           // rlog_d(logTAG, "Process RX433 signal (end of packet): protocol=%d, value=0x%.8X, count=%d", buf433.rx433.value, buf433.rx433.value, buf433.count);
-          alarmProcessIncomingData(&buf433, true);
+          alarmProcessIncomingData(&buf433, buf433_ts, true);
         };
         rx433_processed = true;
+        alarmEventStatsPacketEnd(buf433.count);
         memset(&buf433, 0, sizeof(input_data_t));
       };
 
@@ -1903,6 +5550,26 @@ bool alarmTaskCreate(ledQueue_t siren, ledQueue_t flasher, ledQueue_t buzzer, le
           return false;
         };
       };
+      if (!_alarmQueueBell) {
+        #if CONFIG_ALARM_STATIC_ALLOCATION
+        _alarmQueueBell = xSemaphoreCreateBinaryStatic(&_alarmQueueBellBuffer);
+        #else
+        _alarmQueueBell = xSemaphoreCreateBinary();
+        #endif // CONFIG_ALARM_STATIC_ALLOCATION
+        if (!_alarmQueueBell) {
+          rloga_e("Failed to create a queue for fire-alarm task!");
+          return false;
+        };
+      };
+      if (!_alarmQueueSet) {
+        _alarmQueueSet = xQueueCreateSet(CONFIG_ALARM_QUEUE_SIZE + 1);
+        if (!_alarmQueueSet 
+         || (xQueueAddToSet(_alarmQueue, _alarmQueueSet) != pdPASS)
+         || (xQueueAddToSet(_alarmQueueBell, _alarmQueueSet) != pdPASS)) {
+          rloga_e("Failed to create a queue set for fire-alarm task!");
+          return false;
+        };
+      };
       
       #if CONFIG_ALARM_STATIC_ALLOCATION
       _alarmTask = xTaskCreateStaticPinnedToCore(alarmTaskExec, alarmTaskName, CONFIG_ALARM_STACK_SIZE, nullptr, CONFIG_TASK_PRIORITY_ALARM, _alarmTaskStack, &_alarmTaskBuffer, CONFIG_TASK_CORE_ALARM); 
@@ -1916,7 +5583,7 @@ bool alarmTaskCreate(ledQueue_t siren, ledQueue_t flasher, ledQueue_t buzzer, le
       }
       else {
         rloga_i("Task [ %s ] has been successfully started", alarmTaskName);
-        return alarmTaskRegisterHandlers(true);
+        return alarmEffectsTaskCreate() && alarmEolTaskCreate() && alarmTaskRegisterHandlers(true);
       };
     };
   };
@@ -1927,7 +5594,9 @@ bool alarmTaskSuspend()
 {
   if ((_alarmTask) && (eTaskGetState(_alarmTask) != eSuspended)) {
     alarmTaskUnregisterHandlers(false);
+    if (_alarmEolTask) vTaskSuspend(_alarmEolTask);
     vTaskSuspend(_alarmTask);
+    alarmEffectsTaskSuspend(true);
     if (eTaskGetState(_alarmTask) == eSuspended) {
       rloga_d("Task [ %s ] has been suspended", alarmTaskName);
     } else {
@@ -1940,7 +5609,9 @@ bool alarmTaskSuspend()
 bool alarmTaskResume()
 {
   if ((_alarmTask) && (eTaskGetState(_alarmTask) == eSuspended)) {
+    alarmEffectsTaskSuspend(false);
     vTaskResume(_alarmTask);
+    if (_alarmEolTask) vTaskResume(_alarmEolTask);
     if (eTaskGetState(_alarmTask) != eSuspended) {
       rloga_i("Task [ %s ] has been successfully resumed", alarmTaskName);
       return alarmTaskRegisterHandlers(false);
@@ -1954,15 +5625,27 @@ bool alarmTaskResume()
 void alarmTaskDelete()
 {
   if (_alarmTask != nullptr) {
+    alarmEolTaskDelete();
+    if (_alarmQueueSet != nullptr) {
+      xQueueRemoveFromSet(_alarmQueue, _alarmQueueSet);
+      xQueueRemoveFromSet(_alarmQueueBell, _alarmQueueSet);
+      vQueueDelete(_alarmQueueSet);
+      _alarmQueueSet = nullptr;
+    };
     if (_alarmQueue != nullptr) {
       vQueueDelete(_alarmQueue);
       _alarmQueue = nullptr;
     };
+    if (_alarmQueueBell != nullptr) {
+      vSemaphoreDelete(_alarmQueueBell);
+      _alarmQueueBell = nullptr;
+    };
 
     alarmTaskUnregisterHandlers(true);
     vTaskDelete(_alarmTask);
     _alarmTask = nullptr;
     rloga_d("Task [ %s ] was deleted", alarmTaskName);
+    alarmEffectsTaskDelete();
 
     alarmSensorsFree();
     alarmZonesFree();
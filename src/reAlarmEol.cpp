@@ -0,0 +1,57 @@
+#include "reAlarmEol.h"
+
+// The boundary between the lower state and the next one shifts away from the current state
+static uint16_t alarmEolBoundary(uint16_t boundary, alarm_eol_state_t lower, alarm_eol_state_t current, uint16_t hysteresis)
+{
+  if (current == lower) {
+    return (boundary > UINT16_MAX - hysteresis) ? UINT16_MAX : boundary + hysteresis;
+  } else if (current == (alarm_eol_state_t)(lower + 1)) {
+    return (boundary > hysteresis) ? boundary - hysteresis : 0;
+  };
+  return boundary;
+}
+
+alarm_eol_state_t alarmEolClassify(const alarmEolThresholds_t* thresholds, alarm_eol_state_t current, uint16_t value)
+{
+  uint16_t h = thresholds->hysteresis;
+  if (value <= alarmEolBoundary(thresholds->short_max, AEL_SHORT, current, h)) {
+    return AEL_SHORT;
+  } else if (value <= alarmEolBoundary(thresholds->normal_max, AEL_NORMAL, current, h)) {
+    return AEL_NORMAL;
+  } else if (value <= alarmEolBoundary(thresholds->alarm_max, AEL_ALARM, current, h)) {
+    return AEL_ALARM;
+  };
+  return AEL_TAMPER;
+}
+
+void alarmEolFilterInit(alarmEolFilter_t* filter)
+{
+  filter->state = AEL_UNKNOWN;
+  filter->candidate = AEL_UNKNOWN;
+  filter->count = 0;
+}
+
+bool alarmEolFilterUpdate(alarmEolFilter_t* filter, const alarmEolThresholds_t* thresholds, uint16_t value)
+{
+  alarm_eol_state_t state = alarmEolClassify(thresholds, filter->state, value);
+  if (state == filter->state) {
+    filter->candidate = state;
+    filter->count = 0;
+    return false;
+  };
+
+  if (state == filter->candidate) {
+    if (filter->count < UINT8_MAX) filter->count++;
+  } else {
+    filter->candidate = state;
+    filter->count = 1;
+  };
+
+  uint8_t debounce = thresholds->debounce > 0 ? thresholds->debounce : 1;
+  if (filter->count >= debounce) {
+    filter->state = state;
+    filter->count = 0;
+    return true;
+  };
+  return false;
+}
@@ -0,0 +1,59 @@
+#include "reAlarmPack.h"
+#include <stdlib.h>
+
+void alarmPackInit(alarmPack_t* pack, uint8_t* buf, size_t size, alarm_pack_kind_t kind)
+{
+  pack->buf = buf;
+  pack->size = size;
+  pack->len = 0;
+  pack->overflow = false;
+  alarmPackU8(pack, ALARM_PACK_SCHEMA);
+  alarmPackU8(pack, (uint8_t)kind);
+}
+
+static void alarmPackBytes(alarmPack_t* pack, uint32_t value, uint8_t count)
+{
+  if (pack->len + count > pack->size) {
+    pack->overflow = true;
+    return;
+  };
+  for (uint8_t i = 0; i < count; i++) {
+    pack->buf[pack->len++] = (uint8_t)(value >> (8 * i));
+  };
+}
+
+void alarmPackU8(alarmPack_t* pack, uint8_t value)
+{
+  alarmPackBytes(pack, value, 1);
+}
+
+void alarmPackU16(alarmPack_t* pack, uint16_t value)
+{
+  alarmPackBytes(pack, value, 2);
+}
+
+void alarmPackU32(alarmPack_t* pack, uint32_t value)
+{
+  alarmPackBytes(pack, value, 4);
+}
+
+char* alarmPackBase64(const alarmPack_t* pack)
+{
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  if (pack->overflow) return NULL;
+  char* ret = (char*)malloc(((pack->len + 2) / 3) * 4 + 1);
+  if (ret) {
+    char* out = ret;
+    for (size_t i = 0; i < pack->len; i += 3) {
+      uint32_t triple = (uint32_t)pack->buf[i] << 16;
+      if (i + 1 < pack->len) triple |= (uint32_t)pack->buf[i + 1] << 8;
+      if (i + 2 < pack->len) triple |= pack->buf[i + 2];
+      *out++ = alphabet[(triple >> 18) & 0x3F];
+      *out++ = alphabet[(triple >> 12) & 0x3F];
+      *out++ = (i + 1 < pack->len) ? alphabet[(triple >> 6) & 0x3F] : '=';
+      *out++ = (i + 2 < pack->len) ? alphabet[triple & 0x3F] : '=';
+    };
+    *out = '\0';
+  };
+  return ret;
+}
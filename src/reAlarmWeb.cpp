@@ -0,0 +1,51 @@
+#include "reAlarmWeb.h"
+#include <stdio.h>
+
+bool alarmWebZoneChanged(const alarmSnapshotZone_t* a, const alarmSnapshotZone_t* b)
+{
+  return (a->topic != b->topic) || (a->mode != b->mode) || (a->status != b->status) || (a->bypass != b->bypass)
+    || (a->relay != b->relay) || (a->last_set != b->last_set) || (a->last_clr != b->last_clr);
+}
+
+size_t alarmWebFormat(const alarmSnapshot_t* snapshot, const alarmSnapshot_t* prev, char* buf, size_t size)
+{
+  size_t len = 0;
+  int n = snprintf(buf, size,
+    "{\"seq\":%u,\"delta\":%d,\"mode\":%d,\"alarms\":%d,\"siren\":%d,\"flasher\":%d,\"last_alarm\":%lld,\"last_event\":%lld,\"zones\":{",
+    (unsigned int)snapshot->seq, prev ? 1 : 0, snapshot->mode, snapshot->alarms, snapshot->siren, snapshot->flasher,
+    (long long)snapshot->last_alarm, (long long)snapshot->last_event);
+  if ((n < 0) || ((size_t)n >= size)) return 0;
+  len = n;
+
+  bool first = true;
+  for (uint8_t i = 0; i < snapshot->zones_count; i++) {
+    const alarmSnapshotZone_t* zone = &snapshot->zones[i];
+    if (prev && (i < prev->zones_count) && !alarmWebZoneChanged(zone, &prev->zones[i])) continue;
+    n = snprintf(buf + len, size - len,
+      "%s\"%s\":{\"mode\":%d,\"status\":%d,\"bypass\":%d,\"relay\":%d,\"last_alarm\":%lld,\"last_clear\":%lld}",
+      first ? "" : ",", zone->topic ? zone->topic : "", zone->mode, zone->status, zone->bypass, zone->relay,
+      (long long)zone->last_set, (long long)zone->last_clr);
+    if ((n < 0) || ((size_t)n >= size - len)) return 0;
+    len += n;
+    first = false;
+  };
+
+  n = snprintf(buf + len, size - len, "}}");
+  if ((n < 0) || ((size_t)n >= size - len)) return 0;
+  return len + n;
+}
+
+void alarmWebDeltaReset(alarmWebDelta_t* delta)
+{
+  delta->valid = false;
+}
+
+int alarmWebDeltaFormat(alarmWebDelta_t* delta, const alarmSnapshot_t* snapshot, char* buf, size_t size)
+{
+  if (delta->valid && (snapshot->seq == delta->sent.seq)) return 0;
+  size_t len = alarmWebFormat(snapshot, delta->valid ? &delta->sent : NULL, buf, size);
+  if (len == 0) return -1;
+  delta->sent = *snapshot;
+  delta->valid = true;
+  return (int)len;
+}
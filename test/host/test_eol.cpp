@@ -0,0 +1,110 @@
+/*
+   EN: Host test: replay of recorded sample streams through the end-of-line classifier
+   RU: Тест на хосте: воспроизведение записанных последовательностей отсчетов через классификатор шлейфа
+   --------------------------
+   g++ -std=gnu++17 -Wall -Wextra -Iinclude src/reAlarmEol.cpp test/host/test_eol.cpp -o test_eol && ./test_eol
+*/
+
+#include <stdio.h>
+#include "reAlarmEol.h"
+
+// Thresholds of the recordings: 12-bit ADC, 3 samples in a row to change the state
+static const alarmEolThresholds_t thresholds = { 300, 1500, 3000, 50, 3 };
+
+// Recorded sample and the line state expected after it
+typedef struct {
+  uint16_t value;
+  alarm_eol_state_t state;
+} eolSample_t;
+
+typedef struct {
+  const char* name;
+  alarm_eol_state_t initial;
+  const eolSample_t* samples;
+  size_t count;
+} eolStream_t;
+
+// Power-up: the first confirmed state leaves AEL_UNKNOWN only after debounce samples, a spike restarts the count
+static const eolSample_t streamStartup[] = {
+  { 1012, AEL_UNKNOWN }, { 1008, AEL_UNKNOWN }, { 4095, AEL_UNKNOWN },
+  { 1010, AEL_UNKNOWN }, { 1011, AEL_UNKNOWN }, { 1009, AEL_NORMAL  }, { 1010, AEL_NORMAL }
+};
+
+// Broken line right after power-up
+static const eolSample_t streamStartupTamper[] = {
+  { 4095, AEL_UNKNOWN }, { 4095, AEL_UNKNOWN }, { 4095, AEL_TAMPER }
+};
+
+// Short / normal boundary (300 +/- 50)
+static const eolSample_t streamShortNormal[] = {
+  // Normal holds down to 251
+  { 260, AEL_NORMAL }, { 251, AEL_NORMAL }, { 255, AEL_NORMAL }, { 260, AEL_NORMAL },
+  { 249, AEL_NORMAL }, { 240, AEL_NORMAL }, { 200, AEL_SHORT  },
+  // Short holds up to 350
+  { 340, AEL_SHORT  }, { 350, AEL_SHORT  }, { 345, AEL_SHORT  }, { 349, AEL_SHORT  },
+  { 351, AEL_SHORT  }, { 360, AEL_SHORT  }, { 400, AEL_NORMAL }
+};
+
+// Normal / alarm boundary (1500 +/- 50): a door contact opening and closing with noise around the threshold
+static const eolSample_t streamNormalAlarm[] = {
+  { 1540, AEL_NORMAL }, { 1550, AEL_NORMAL }, { 1520, AEL_NORMAL }, { 1545, AEL_NORMAL },
+  // Interrupted candidate does not change the state
+  { 1560, AEL_NORMAL }, { 1570, AEL_NORMAL }, { 1490, AEL_NORMAL },
+  { 1560, AEL_NORMAL }, { 2100, AEL_NORMAL }, { 2110, AEL_ALARM  },
+  // Alarm holds down to 1451
+  { 1460, AEL_ALARM  }, { 1451, AEL_ALARM  }, { 1470, AEL_ALARM  },
+  { 1450, AEL_ALARM  }, { 1440, AEL_ALARM  }, { 1000, AEL_NORMAL }
+};
+
+// Alarm / tamper boundary (3000 +/- 50)
+static const eolSample_t streamAlarmTamper[] = {
+  { 3040, AEL_ALARM  }, { 3050, AEL_ALARM  }, { 3020, AEL_ALARM  },
+  { 3051, AEL_ALARM  }, { 3060, AEL_ALARM  }, { 4095, AEL_TAMPER },
+  // Tamper holds down to 2951
+  { 2960, AEL_TAMPER }, { 2951, AEL_TAMPER }, { 2990, AEL_TAMPER },
+  { 2950, AEL_TAMPER }, { 2940, AEL_TAMPER }, { 2100, AEL_ALARM  }
+};
+
+#define STREAM(name, initial, samples) { name, initial, samples, sizeof(samples) / sizeof(samples[0]) }
+
+static const eolStream_t streams[] = {
+  STREAM("startup", AEL_UNKNOWN, streamStartup),
+  STREAM("startup tamper", AEL_UNKNOWN, streamStartupTamper),
+  STREAM("short / normal", AEL_NORMAL, streamShortNormal),
+  STREAM("normal / alarm", AEL_NORMAL, streamNormalAlarm),
+  STREAM("alarm / tamper", AEL_ALARM, streamAlarmTamper),
+};
+
+static int replay(const eolStream_t* stream)
+{
+  int errors = 0;
+  alarmEolFilter_t filter;
+  alarmEolFilterInit(&filter);
+  filter.state = stream->initial;
+  filter.candidate = stream->initial;
+  for (size_t i = 0; i < stream->count; i++) {
+    alarm_eol_state_t prev = filter.state;
+    bool changed = alarmEolFilterUpdate(&filter, &thresholds, stream->samples[i].value);
+    if (filter.state != stream->samples[i].state) {
+      printf("FAIL [%s] sample %u (%u): state %d, expected %d\n",
+        stream->name, (unsigned)i, stream->samples[i].value, filter.state, stream->samples[i].state);
+      errors++;
+    } else if (changed != (prev != filter.state)) {
+      printf("FAIL [%s] sample %u (%u): change reported %d\n", stream->name, (unsigned)i, stream->samples[i].value, changed);
+      errors++;
+    };
+  };
+  return errors;
+}
+
+int main()
+{
+  int errors = 0;
+  for (size_t i = 0; i < sizeof(streams) / sizeof(streams[0]); i++) {
+    errors += replay(&streams[i]);
+  };
+  if (errors == 0) {
+    printf("OK: %u streams\n", (unsigned)(sizeof(streams) / sizeof(streams[0])));
+  };
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+/*
+   EN: Host test: web status serialization and deltas against a stand-in WebSocket server
+   RU: Тест на хосте: сериализация состояния и рассылка изменений через имитацию WebSocket-сервера
+   --------------------------
+   g++ -std=gnu++17 -Wall -Wextra -Iinclude src/reAlarmWeb.cpp test/host/test_web.cpp -o test_web && ./test_web
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "reAlarmWeb.h"
+
+#define STAND_IN_MAX_CLIENTS 4
+#define STAND_IN_BUFFER_SIZE 1024
+
+/**
+ * Stand-in for esp_http_server: the handshake handler sends the full status to a new client, the push work
+ * serializes the delta once and sends the same frame to every connected client, as alarmWebPushWork() does
+ * */
+typedef struct {
+  bool connected;
+  char last[STAND_IN_BUFFER_SIZE];
+  int frames;
+} standInClient_t;
+
+typedef struct {
+  standInClient_t clients[STAND_IN_MAX_CLIENTS];
+  alarmWebDelta_t delta;
+  char buffer[STAND_IN_BUFFER_SIZE];
+} standInServer_t;
+
+static void standInSend(standInClient_t* client, const char* frame)
+{
+  strncpy(client->last, frame, sizeof(client->last) - 1);
+  client->frames++;
+}
+
+static bool standInConnect(standInServer_t* server, int fd, const alarmSnapshot_t* snapshot)
+{
+  if (alarmWebFormat(snapshot, NULL, server->buffer, sizeof(server->buffer)) == 0) return false;
+  server->clients[fd].connected = true;
+  standInSend(&server->clients[fd], server->buffer);
+  return true;
+}
+
+// Returns the length of the frame sent, 0 - nothing to send, -1 - buffer is too small
+static int standInPush(standInServer_t* server, const alarmSnapshot_t* snapshot, size_t size)
+{
+  int len = alarmWebDeltaFormat(&server->delta, snapshot, server->buffer, size);
+  if (len > 0) {
+    for (int i = 0; i < STAND_IN_MAX_CLIENTS; i++) {
+      if (server->clients[i].connected) standInSend(&server->clients[i], server->buffer);
+    };
+  };
+  return len;
+}
+
+static int errors = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); errors++; }; } while (0)
+
+static void snapshotInit(alarmSnapshot_t* snapshot)
+{
+  static const char* topics[] = { "door", "hall", "garage" };
+  memset(snapshot, 0, sizeof(alarmSnapshot_t));
+  snapshot->seq = 1;
+  snapshot->mode = 1;
+  snapshot->zones_count = 3;
+  for (uint8_t i = 0; i < snapshot->zones_count; i++) {
+    snapshot->zones[i].topic = topics[i];
+    snapshot->zones[i].mode = 1;
+  };
+}
+
+int main()
+{
+  static standInServer_t server;
+  memset(&server, 0, sizeof(server));
+  alarmWebDeltaReset(&server.delta);
+  alarmSnapshot_t snapshot;
+  snapshotInit(&snapshot);
+
+  // First client: full status
+  CHECK(standInConnect(&server, 0, &snapshot));
+  CHECK(strstr(server.clients[0].last, "\"delta\":0") != NULL);
+  CHECK(strstr(server.clients[0].last, "\"door\"") && strstr(server.clients[0].last, "\"hall\"") && strstr(server.clients[0].last, "\"garage\""));
+
+  // The first push after registration is a full status too
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strstr(server.clients[0].last, "\"delta\":0") != NULL);
+  CHECK(server.clients[0].frames == 2);
+
+  // Same sequence number: nothing is sent
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) == 0);
+  CHECK(server.clients[0].frames == 2);
+
+  // One zone changed: the delta contains only this zone
+  snapshot.seq++;
+  snapshot.alarms = 1;
+  snapshot.siren = true;
+  snapshot.zones[1].status = 1;
+  snapshot.zones[1].last_set = 1700000000;
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strstr(server.clients[0].last, "\"delta\":1") != NULL);
+  CHECK(strstr(server.clients[0].last, "\"siren\":1") != NULL);
+  CHECK(strstr(server.clients[0].last, "\"hall\":{\"mode\":1,\"status\":1,\"bypass\":0,\"relay\":0,\"last_alarm\":1700000000,\"last_clear\":0}") != NULL);
+  CHECK(strstr(server.clients[0].last, "\"door\"") == NULL);
+  CHECK(strstr(server.clients[0].last, "\"garage\"") == NULL);
+
+  // Second client joins: it gets the full status, later deltas go to both clients
+  CHECK(standInConnect(&server, 1, &snapshot));
+  CHECK(strstr(server.clients[1].last, "\"delta\":0") && strstr(server.clients[1].last, "\"door\""));
+  snapshot.seq++;
+  snapshot.zones[2].bypass = 1;
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strcmp(server.clients[0].last, server.clients[1].last) == 0);
+  CHECK(strstr(server.clients[1].last, "\"garage\"") && !strstr(server.clients[1].last, "\"hall\""));
+
+  // Only common fields changed: the delta has no zones
+  snapshot.seq++;
+  snapshot.siren = false;
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strstr(server.clients[0].last, "\"zones\":{}}") != NULL);
+
+  // A zone added to the snapshot is always sent
+  snapshot.seq++;
+  snapshot.zones_count = 4;
+  snapshot.zones[3].topic = "yard";
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strstr(server.clients[0].last, "\"yard\"") != NULL);
+
+  // Too small buffer: an error, the snapshot is not remembered as sent
+  snapshot.seq++;
+  snapshot.zones[0].status = 2;
+  int frames = server.clients[0].frames;
+  CHECK(standInPush(&server, &snapshot, 32) == -1);
+  CHECK(server.clients[0].frames == frames);
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strstr(server.clients[0].last, "\"door\":{\"mode\":1,\"status\":2") != NULL);
+
+  // After re-registration the next push is a full status again
+  alarmWebDeltaReset(&server.delta);
+  CHECK(standInPush(&server, &snapshot, sizeof(server.buffer)) > 0);
+  CHECK(strstr(server.clients[0].last, "\"delta\":0") && strstr(server.clients[0].last, "\"hall\""));
+
+  if (errors == 0) {
+    printf("OK\n");
+  };
+  return errors == 0 ? 0 : 1;
+}